@@ -1,3 +1,33 @@
-from ._surfio import IrapHeader, IrapSurface
+from ._surfio import (
+    IoBackend,
+    IoOptions,
+    IrapHeader,
+    IrapSurface,
+    PyramidReduction,
+    SurfaceExpression,
+    ValidationReport,
+    fmax,
+    fmin,
+    validate_ascii_file,
+    validate_ascii_string,
+    validate_binary_buffer,
+    validate_binary_file,
+    where,
+)
 
-__all__ = ["IrapHeader", "IrapSurface"]
+__all__ = [
+    "IoBackend",
+    "IoOptions",
+    "IrapHeader",
+    "IrapSurface",
+    "PyramidReduction",
+    "SurfaceExpression",
+    "ValidationReport",
+    "fmax",
+    "fmin",
+    "validate_ascii_file",
+    "validate_ascii_string",
+    "validate_binary_buffer",
+    "validate_binary_file",
+    "where",
+]
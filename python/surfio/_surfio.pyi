@@ -1,8 +1,11 @@
+import enum
 import os
-from typing import ClassVar
+from multiprocessing.shared_memory import SharedMemory
+from typing import ClassVar, TypeAlias
 
 import numpy
 import numpy.typing as npt
+from typing_extensions import Buffer
 
 class IrapHeader:
     id: ClassVar[int] = ...  # read-only
@@ -33,6 +36,31 @@ class IrapHeader:
     ) -> None: ...
     def __eq__(self, arg0: object) -> bool: ...
     def __ne__(self, arg0: object) -> bool: ...
+    def __getstate__(self) -> tuple: ...
+    def __setstate__(self, arg0: tuple) -> None: ...
+
+class PyramidReduction(enum.Enum):
+    mean = ...
+    min = ...
+    max = ...
+
+class IoBackend(enum.Enum):
+    automatic = ...
+    mmap = ...
+    pread = ...
+    direct = ...
+
+class IoOptions:
+    backend: IoBackend
+    populate: bool
+    huge_pages: bool
+    def __init__(
+        self,
+        *,
+        backend: IoBackend = ...,
+        populate: bool = False,
+        huge_pages: bool = False,
+    ) -> None: ...
 
 class IrapSurface:
     header: IrapHeader
@@ -41,14 +69,120 @@ class IrapSurface:
         self, header: IrapHeader, values: npt.NDArray[numpy.float32]
     ) -> None: ...
     @staticmethod
-    def from_ascii_file(arg0: os.PathLike) -> IrapSurface: ...
+    def from_ascii_file(
+        file: os.PathLike, *, io_options: IoOptions = ...
+    ) -> IrapSurface: ...
     @staticmethod
-    def from_ascii_string(arg0: str) -> IrapSurface: ...
+    def from_ascii_string(arg0: str | Buffer) -> IrapSurface: ...
     @staticmethod
-    def from_binary_buffer(arg0: bytes) -> IrapSurface: ...
+    def from_binary_buffer(arg0: Buffer) -> IrapSurface: ...
     @staticmethod
-    def from_binary_file(arg0: os.PathLike) -> IrapSurface: ...
+    def from_binary_file(
+        file: os.PathLike, *, io_options: IoOptions = ...
+    ) -> IrapSurface: ...
     def to_ascii_file(self, arg0: os.PathLike) -> None: ...
     def to_ascii_string(self) -> str: ...
     def to_binary_buffer(self) -> bytes: ...
     def to_binary_file(self, arg0: os.PathLike) -> None: ...
+    def __getstate__(self) -> tuple: ...
+    def __setstate__(self, arg0: tuple) -> None: ...
+    def to_shared_memory(self, name: str | None = None) -> SharedMemory: ...
+    @staticmethod
+    def from_shared_memory(shm: SharedMemory | str) -> IrapSurface: ...
+    def __add__(self, other: Operand) -> SurfaceExpression: ...
+    def __radd__(self, other: Operand) -> SurfaceExpression: ...
+    def __sub__(self, other: Operand) -> SurfaceExpression: ...
+    def __rsub__(self, other: Operand) -> SurfaceExpression: ...
+    def __mul__(self, other: Operand) -> SurfaceExpression: ...
+    def __rmul__(self, other: Operand) -> SurfaceExpression: ...
+    def __truediv__(self, other: Operand) -> SurfaceExpression: ...
+    def __rtruediv__(self, other: Operand) -> SurfaceExpression: ...
+    def __and__(self, other: Operand) -> SurfaceExpression: ...
+    def __rand__(self, other: Operand) -> SurfaceExpression: ...
+    def __or__(self, other: Operand) -> SurfaceExpression: ...
+    def __ror__(self, other: Operand) -> SurfaceExpression: ...
+    def __lt__(self, other: Operand) -> SurfaceExpression: ...
+    def __le__(self, other: Operand) -> SurfaceExpression: ...
+    def __gt__(self, other: Operand) -> SurfaceExpression: ...
+    def __ge__(self, other: Operand) -> SurfaceExpression: ...
+    def __neg__(self) -> SurfaceExpression: ...
+    def __abs__(self) -> SurfaceExpression: ...
+    def __invert__(self) -> SurfaceExpression: ...
+    def clip(
+        self, lower: Operand | None = None, upper: Operand | None = None
+    ) -> SurfaceExpression: ...
+    def make_pyramid(
+        self, levels: int, reduction: PyramidReduction = ...
+    ) -> list[IrapSurface]: ...
+    @staticmethod
+    def pyramid_from_ascii_file(
+        file: os.PathLike,
+        levels: int,
+        reduction: PyramidReduction = ...,
+        *,
+        io_options: IoOptions = ...,
+    ) -> list[IrapSurface]: ...
+    @staticmethod
+    def pyramid_from_binary_file(
+        file: os.PathLike,
+        levels: int,
+        reduction: PyramidReduction = ...,
+        *,
+        io_options: IoOptions = ...,
+    ) -> list[IrapSurface]: ...
+
+class SurfaceExpression:
+    header: IrapHeader | None  # read-only
+    def evaluate(self) -> IrapSurface: ...
+    def __bool__(self) -> bool: ...
+    def __add__(self, other: Operand) -> SurfaceExpression: ...
+    def __radd__(self, other: Operand) -> SurfaceExpression: ...
+    def __sub__(self, other: Operand) -> SurfaceExpression: ...
+    def __rsub__(self, other: Operand) -> SurfaceExpression: ...
+    def __mul__(self, other: Operand) -> SurfaceExpression: ...
+    def __rmul__(self, other: Operand) -> SurfaceExpression: ...
+    def __truediv__(self, other: Operand) -> SurfaceExpression: ...
+    def __rtruediv__(self, other: Operand) -> SurfaceExpression: ...
+    def __and__(self, other: Operand) -> SurfaceExpression: ...
+    def __rand__(self, other: Operand) -> SurfaceExpression: ...
+    def __or__(self, other: Operand) -> SurfaceExpression: ...
+    def __ror__(self, other: Operand) -> SurfaceExpression: ...
+    def __lt__(self, other: Operand) -> SurfaceExpression: ...
+    def __le__(self, other: Operand) -> SurfaceExpression: ...
+    def __gt__(self, other: Operand) -> SurfaceExpression: ...
+    def __ge__(self, other: Operand) -> SurfaceExpression: ...
+    def __neg__(self) -> SurfaceExpression: ...
+    def __abs__(self) -> SurfaceExpression: ...
+    def __invert__(self) -> SurfaceExpression: ...
+    def clip(
+        self, lower: Operand | None = None, upper: Operand | None = None
+    ) -> SurfaceExpression: ...
+
+Operand: TypeAlias = IrapSurface | SurfaceExpression | float
+
+def fmin(a: Operand, b: Operand) -> SurfaceExpression: ...
+def fmax(a: Operand, b: Operand) -> SurfaceExpression: ...
+def where(
+    condition: Operand, if_true: Operand, if_false: Operand | None = None
+) -> SurfaceExpression: ...
+
+class ValidationReport:
+    valid: bool  # read-only
+    error: str  # read-only
+    first_bad_offset: int | None  # read-only
+    expected_guard: int | None  # read-only
+    actual_guard: int | None  # read-only
+    header: IrapHeader | None  # read-only
+    expected_values: int  # read-only
+    value_count: int  # read-only
+    undef_count: int  # read-only
+    def __bool__(self) -> bool: ...
+
+def validate_ascii_file(
+    file: os.PathLike, *, io_options: IoOptions = ...
+) -> ValidationReport: ...
+def validate_ascii_string(buffer: str | Buffer) -> ValidationReport: ...
+def validate_binary_buffer(buffer: Buffer) -> ValidationReport: ...
+def validate_binary_file(
+    file: os.PathLike, *, io_options: IoOptions = ...
+) -> ValidationReport: ...
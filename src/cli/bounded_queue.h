@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace surfio::cli {
+// A queue holding at most capacity items, connecting a producer thread to a consumer
+// thread. push blocks while the queue is full and pop blocks while it is empty. Once
+// closed, push discards items and pop drains the remaining items before returning
+// nullopt.
+template <typename T> class bounded_queue {
+public:
+  explicit bounded_queue(size_t capacity) : capacity(capacity) {}
+
+  // Returns false if the queue was closed, in which case value is discarded
+  bool push(T value) {
+    std::unique_lock lock(mutex);
+    not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+    if (closed)
+      return false;
+    items.push_back(std::move(value));
+    not_empty.notify_one();
+    return true;
+  }
+
+  std::optional<T> pop() {
+    std::unique_lock lock(mutex);
+    not_empty.wait(lock, [&] { return closed || !items.empty(); });
+    if (items.empty())
+      return std::nullopt;
+    auto value = std::move(items.front());
+    items.pop_front();
+    not_full.notify_one();
+    return value;
+  }
+
+  void close() {
+    std::lock_guard lock(mutex);
+    closed = true;
+    not_full.notify_all();
+    not_empty.notify_all();
+  }
+
+private:
+  size_t capacity;
+  bool closed = false;
+  std::deque<T> items;
+  std::mutex mutex;
+  std::condition_variable not_full;
+  std::condition_variable not_empty;
+};
+} // namespace surfio::cli
@@ -0,0 +1,141 @@
+#include "convert.h"
+#include "bounded_queue.h"
+#include <chrono>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <irap_export.h>
+#include <irap_import.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace surfio::cli {
+file_format detect_format(const fs::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  char guard[4] = {};
+  in.read(guard, sizeof(guard));
+  return in.gcount() == 4 && guard[0] == 0 && guard[1] == 0 && guard[2] == 0 && guard[3] == 32
+             ? file_format::binary
+             : file_format::ascii;
+}
+
+struct block {
+  size_t offset;
+  std::vector<float> values;
+};
+
+// Thrown from the block callback to stop reading when the writer has failed
+struct writer_stopped {};
+
+// Encode and write the blocks of one file until the queue is closed
+uintmax_t write_blocks(
+    bounded_queue<block>& queue, const irap::irap_header& header, file_format to,
+    std::ofstream& out, const fs::path& output
+) {
+  const auto nvalues = size_t(header.ncol) * size_t(header.nrow);
+  uintmax_t written = 0;
+  std::string buffer;
+  auto flush = [&] {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!out)
+      throw std::runtime_error(std::format("failed to write file :{}", output.string()));
+    written += buffer.size();
+    buffer.clear();
+  };
+
+  if (to == file_format::ascii)
+    irap::encode_header_ascii(header, buffer);
+  else
+    irap::encode_header_binary(header, buffer);
+  flush();
+  while (auto b = queue.pop()) {
+    if (to == file_format::ascii)
+      irap::encode_values_ascii(b->values, b->offset, buffer);
+    else
+      irap::encode_values_binary(b->values, b->offset, nvalues, buffer);
+    flush();
+  }
+  out.close();
+  if (!out)
+    throw std::runtime_error(std::format("failed to write file :{}", output.string()));
+  return written;
+}
+
+conversion
+convert_file(const fs::path& input, const fs::path& output, const convert_options& opts) {
+  auto start = std::chrono::steady_clock::now();
+  if (fs::exists(output) && fs::equivalent(input, output))
+    throw std::runtime_error(std::format("output file is the input file :{}", input.string()));
+
+  auto from = opts.from ? *opts.from : detect_format(input);
+  auto read_blocks =
+      from == file_format::ascii ? &irap::read_ascii_file_blocks : &irap::read_binary_file_blocks;
+
+  conversion result;
+  bounded_queue<block> queue(opts.queue_blocks);
+  std::ofstream out;
+  bool opened = false;
+  std::exception_ptr writer_error;
+  std::jthread writer;
+  auto stop_writer = [&] {
+    queue.close();
+    if (writer.joinable())
+      writer.join();
+  };
+  // Only a file opened by this call is removed, so a failure before the header is
+  // read (e.g. a missing input) leaves an existing output from an earlier run alone
+  auto remove_output = [&] {
+    out.close();
+    std::error_code ec;
+    if (opened && fs::is_regular_file(output, ec))
+      fs::remove(output, ec);
+  };
+
+  try {
+    read_blocks(
+        input, opts.block_rows,
+        [&](const irap::irap_header& header) {
+          result.nvalues = size_t(header.ncol) * size_t(header.nrow);
+          // the ascii output is opened in text mode, like to_ascii_file
+          out.open(output, opts.to == file_format::binary ? std::ios::binary : std::ios::out);
+          if (!out)
+            throw std::runtime_error(std::format("failed to open file :{}", output.string()));
+          opened = true;
+          writer = std::jthread([&, header] {
+            try {
+              result.bytes_written = write_blocks(queue, header, opts.to, out, output);
+            } catch (...) {
+              writer_error = std::current_exception();
+              queue.close();
+            }
+          });
+        },
+        [&](size_t offset, std::span<const float> values) {
+          if (!queue.push({offset, {values.begin(), values.end()}}))
+            throw writer_stopped{};
+        },
+        opts.io
+    );
+    stop_writer();
+  } catch (const writer_stopped&) {
+    stop_writer();
+  } catch (...) {
+    stop_writer();
+    remove_output();
+    throw;
+  }
+  if (writer_error) {
+    remove_output();
+    std::rethrow_exception(writer_error);
+  }
+
+  result.bytes_read = fs::file_size(input);
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
+} // namespace surfio::cli
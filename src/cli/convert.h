@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <io_options.h>
+#include <optional>
+
+namespace surfio::cli {
+enum class file_format { ascii, binary };
+
+struct convert_options {
+  // format of the input files, detected for each file when not set
+  std::optional<file_format> from;
+  file_format to = file_format::binary;
+  // number of rows in each block read from the input
+  size_t block_rows = 256;
+  // number of blocks buffered between reading and writing a file
+  size_t queue_blocks = 4;
+  irap::io_options io;
+};
+
+struct conversion {
+  size_t nvalues = 0;
+  uintmax_t bytes_read = 0;
+  uintmax_t bytes_written = 0;
+  double seconds = 0.;
+};
+
+// A file is detected as binary when its first 4 bytes are the big endian guard value 32 of
+// the first header record, and as ascii otherwise
+file_format detect_format(const std::filesystem::path& file);
+
+// Decode the input on the calling thread while another thread encodes and writes the
+// output, with at most opts.queue_blocks blocks in flight between them. If the
+// conversion fails after the output was opened, the partial output is removed.
+conversion convert_file(
+    const std::filesystem::path& input, const std::filesystem::path& output,
+    const convert_options& opts
+);
+} // namespace surfio::cli
@@ -0,0 +1,215 @@
+#include "convert.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace surfio;
+using cli::file_format;
+
+namespace {
+constexpr std::string_view USAGE = R"(Usage: surfio-convert --to {ascii|binary} [options] INPUT...
+
+Convert irap surfaces between the ascii and binary formats. Each file is decoded and
+written a block of rows at a time, so the values of a surface are never held in memory
+in full. The input file itself is memory mapped, or read into memory in full with the
+pread and direct I/O backends.
+
+Options:
+  --to {ascii|binary}       format of the output files
+  --from {ascii|binary}     format of the input files, detected for each file by default
+  -o, --output-dir DIR      directory of the output files, the directory of each input
+                            file by default
+  --suffix SUFFIX           extension of the output files, .irap for ascii and .gri for
+                            binary by default
+  -j, --jobs N              number of files converted at the same time, half the number
+                            of hardware threads by default
+  --block-rows N            number of rows in each block (default: 256)
+  --queue-blocks N          number of blocks buffered between reading and writing each
+                            file (default: 4)
+  --io-backend {mmap|pread|direct}
+                            how input files are read, by default the backend named by
+                            SURFIO_IO_BACKEND or mmap
+  -q, --quiet               only report the total throughput
+  -h, --help                show this message
+)";
+
+struct options {
+  cli::convert_options convert;
+  std::optional<fs::path> output_dir;
+  std::string suffix;
+  size_t jobs = std::max(std::thread::hardware_concurrency() / 2, 1u);
+  bool quiet = false;
+  std::vector<fs::path> inputs;
+};
+
+struct usage_error : std::invalid_argument {
+  using std::invalid_argument::invalid_argument;
+};
+
+file_format parse_format(std::string_view value) {
+  if (value == "ascii")
+    return file_format::ascii;
+  if (value == "binary")
+    return file_format::binary;
+  throw usage_error(std::format("Unknown format: {}. Expected ascii or binary", value));
+}
+
+size_t parse_count(std::string_view option, std::string_view value) {
+  size_t result = 0;
+  auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+  if (ec != std::errc() || ptr != value.data() + value.size() || result == 0)
+    throw usage_error(std::format("{} expects a positive integer, got: {}", option, value));
+  return result;
+}
+
+irap::io_backend parse_backend(std::string_view value) {
+  if (value == "mmap")
+    return irap::io_backend::mmap;
+  if (value == "pread")
+    return irap::io_backend::pread;
+  if (value == "direct")
+    return irap::io_backend::direct;
+  throw usage_error(std::format("Unknown I/O backend: {}. Expected mmap, pread or direct", value));
+}
+
+// Returns nullopt if help was requested
+std::optional<options> parse_arguments(std::span<char*> args) {
+  options result;
+  bool has_to = false;
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::string_view arg = args[i];
+    auto value = [&]() -> std::string_view {
+      if (++i == args.size())
+        throw usage_error(std::format("{} expects a value", arg));
+      return args[i];
+    };
+    if (arg == "-h" || arg == "--help")
+      return std::nullopt;
+    else if (arg == "--to") {
+      result.convert.to = parse_format(value());
+      has_to = true;
+    } else if (arg == "--from")
+      result.convert.from = parse_format(value());
+    else if (arg == "-o" || arg == "--output-dir")
+      result.output_dir = fs::path(value());
+    else if (arg == "--suffix")
+      result.suffix = value();
+    else if (arg == "-j" || arg == "--jobs")
+      result.jobs = parse_count(arg, value());
+    else if (arg == "--block-rows")
+      result.convert.block_rows = parse_count(arg, value());
+    else if (arg == "--queue-blocks")
+      result.convert.queue_blocks = parse_count(arg, value());
+    else if (arg == "--io-backend")
+      result.convert.io.backend = parse_backend(value());
+    else if (arg == "-q" || arg == "--quiet")
+      result.quiet = true;
+    else if (arg.starts_with("-"))
+      throw usage_error(std::format("Unknown option: {}", arg));
+    else
+      result.inputs.emplace_back(arg);
+  }
+  if (!has_to)
+    throw usage_error("--to is required");
+  if (result.inputs.empty())
+    throw usage_error("No input files given");
+  if (result.suffix.empty())
+    result.suffix = result.convert.to == file_format::ascii ? ".irap" : ".gri";
+  return result;
+}
+
+fs::path output_path(const fs::path& input, const options& opts) {
+  auto output = opts.output_dir.value_or(input.parent_path()) / input.filename();
+  output.replace_extension(opts.suffix);
+  return output;
+}
+
+double megabytes(uintmax_t bytes) { return static_cast<double>(bytes) / 1e6; }
+
+int run(const options& opts) {
+  std::vector<fs::path> outputs;
+  for (const auto& input : opts.inputs) {
+    auto output = output_path(input, opts);
+    if (std::ranges::find(outputs, output) != outputs.end())
+      throw usage_error(std::format("More than one input would be written to {}", output.string()));
+    outputs.push_back(std::move(output));
+  }
+  if (opts.output_dir)
+    fs::create_directories(*opts.output_dir);
+
+  std::atomic<size_t> next = 0;
+  std::mutex report_mutex;
+  cli::conversion total;
+  size_t failed = 0;
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> workers;
+    for (size_t j = 0; j < std::min(opts.jobs, opts.inputs.size()); ++j)
+      workers.emplace_back([&] {
+        for (auto i = next++; i < opts.inputs.size(); i = next++) {
+          const auto& input = opts.inputs[i];
+          const auto& output = outputs[i];
+          try {
+            auto result = cli::convert_file(input, output, opts.convert);
+            std::lock_guard lock(report_mutex);
+            total.nvalues += result.nvalues;
+            total.bytes_read += result.bytes_read;
+            total.bytes_written += result.bytes_written;
+            if (!opts.quiet)
+              std::cout << std::format(
+                  "{} -> {}: {} values, {:.1f} MB in {:.3f} s ({:.1f} MB/s)\n", input.string(),
+                  output.string(), result.nvalues, megabytes(result.bytes_read), result.seconds,
+                  megabytes(result.bytes_read) / result.seconds
+              );
+          } catch (const std::exception& e) {
+            std::lock_guard lock(report_mutex);
+            ++failed;
+            std::cerr << std::format("{}: {}\n", input.string(), e.what());
+          }
+        }
+      });
+  }
+  total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << std::format(
+      "Converted {} of {} files in {:.3f} s: {:.1f} MB read ({:.1f} MB/s), {:.1f} MB written "
+      "({:.1f} MB/s), {:.1f} million values/s\n",
+      opts.inputs.size() - failed, opts.inputs.size(), total.seconds, megabytes(total.bytes_read),
+      megabytes(total.bytes_read) / total.seconds, megabytes(total.bytes_written),
+      megabytes(total.bytes_written) / total.seconds,
+      static_cast<double>(total.nvalues) / 1e6 / total.seconds
+  );
+  return failed ? 1 : 0;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  try {
+    auto opts = parse_arguments(std::span(argv, static_cast<size_t>(argc)).subspan(1));
+    if (!opts) {
+      std::cout << USAGE;
+      return 0;
+    }
+    return run(*opts);
+  } catch (const usage_error& e) {
+    std::cerr << std::format("surfio-convert: {}\n\n{}", e.what(), USAGE);
+    return 2;
+  } catch (const std::exception& e) {
+    std::cerr << std::format("surfio-convert: {}\n", e.what());
+    return 1;
+  }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+namespace surfio::irap {
+// Number of values encoded into a buffer before it is written to the stream. Writing
+// the buffer in one call is much faster than streaming each value, and a block this
+// size keeps the buffer small enough to stay in cache.
+constexpr size_t WRITE_BLOCK_SIZE = 4096;
+} // namespace surfio::irap
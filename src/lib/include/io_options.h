@@ -0,0 +1,27 @@
+#pragma once
+
+namespace surfio::irap {
+// How the contents of a file are brought into memory when it is read
+enum class io_backend {
+  // Use the SURFIO_IO_BACKEND environment variable ("mmap", "pread" or "direct"),
+  // or mmap when it is not set
+  automatic,
+  // Memory map the file, advised for sequential access.
+  // Good for local disks where page faults are cheap
+  mmap,
+  // Read the whole file into memory with large pread calls, with sequential
+  // read-ahead advised. Good for network filesystems with slow page faults
+  pread,
+  // Read the whole file into an aligned buffer with O_DIRECT, bypassing the page
+  // cache. Falls back to pread where the platform or filesystem lacks support
+  direct,
+};
+
+struct io_options {
+  io_backend backend = io_backend::automatic;
+  // Fault in the whole mapping before reading (mmap only)
+  bool populate = false;
+  // Ask for transparent huge pages for the mapping (mmap only)
+  bool huge_pages = false;
+};
+} // namespace surfio::irap
@@ -2,6 +2,8 @@
 
 #include "irap.h"
 #include <filesystem>
+#include <span>
+#include <string>
 
 #if __cpp_lib_mdspan
 #include <mdspan>
@@ -38,4 +40,16 @@ void to_binary_file(const std::filesystem::path& file, const irap& data);
 
 std::string to_binary_buffer(const irap_header& header, surf_span values);
 std::string to_binary_buffer(const irap& data);
+
+// Encode a surface one block at a time, for writing surfaces that are never held in
+// memory. Blocks hold values in file order (see read_ascii_file_blocks), offset is
+// the index of the first value of the block, and blocks must be encoded in order.
+// The encoded bytes are appended to out.
+void encode_header_ascii(const irap_header& header, std::string& out);
+void encode_values_ascii(std::span<const float> block, size_t offset, std::string& out);
+
+void encode_header_binary(const irap_header& header, std::string& out);
+void encode_values_binary(
+    std::span<const float> block, size_t offset, size_t nvalues, std::string& out
+);
 } // namespace surfio::irap
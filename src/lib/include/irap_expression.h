@@ -0,0 +1,90 @@
+#pragma once
+
+#include "irap.h"
+#include "irap_export.h"
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace surfio::irap {
+enum class expression_op {
+  negate,
+  abs,
+  logical_not,
+  add,
+  subtract,
+  multiply,
+  divide,
+  // comparisons and logical operations give 1 for true and 0 for false, and NaN if
+  // any operand is NaN
+  less,
+  less_equal,
+  greater,
+  greater_equal,
+  logical_and,
+  logical_or,
+  // minimum and maximum ignoring NaN, like std::fmin and std::fmax
+  fmin,
+  fmax,
+  // where(condition, a, b) is a where condition is non-zero, b where it is zero and NaN
+  // where it is NaN
+  where,
+  // clip(value, lower, upper), where NaN bounds are ignored
+  clip,
+};
+
+// A lazily evaluated expression of surfaces and scalars. Building an expression only
+// records the operations. evaluate computes all of them in one pass over the values,
+// in small blocks on several threads, so no temporaries of the size of the surface are
+// created. All surfaces in an expression must be on the same grid, and their values
+// must outlive the expression.
+class expression {
+public:
+  expression(float value);
+  expression(const irap_header& header, surf_span values);
+  expression(const irap& data);
+  expression(expression_op op, std::initializer_list<expression> operands);
+
+  // Header of the first surface in the expression, if any
+  const std::optional<irap_header>& header() const { return grid; }
+
+  irap evaluate() const;
+  // Evaluate into out, which holds ncol * nrow values
+  void evaluate(std::span<float> out) const;
+
+private:
+  struct node;
+  std::shared_ptr<const node> root;
+  std::optional<irap_header> grid;
+};
+
+// Throws std::domain_error if the headers do not describe the same grid
+void check_compatible(const irap_header& lhs, const irap_header& rhs);
+
+expression operator-(const expression& operand);
+expression operator+(const expression& lhs, const expression& rhs);
+expression operator-(const expression& lhs, const expression& rhs);
+expression operator*(const expression& lhs, const expression& rhs);
+expression operator/(const expression& lhs, const expression& rhs);
+expression operator<(const expression& lhs, const expression& rhs);
+expression operator<=(const expression& lhs, const expression& rhs);
+expression operator>(const expression& lhs, const expression& rhs);
+expression operator>=(const expression& lhs, const expression& rhs);
+
+expression abs(const expression& operand);
+expression logical_not(const expression& operand);
+expression logical_and(const expression& lhs, const expression& rhs);
+expression logical_or(const expression& lhs, const expression& rhs);
+expression fmin(const expression& lhs, const expression& rhs);
+expression fmax(const expression& lhs, const expression& rhs);
+expression where(
+    const expression& condition, const expression& if_true,
+    const expression& if_false = std::numeric_limits<float>::quiet_NaN()
+);
+expression clip(
+    const expression& value, const expression& lower = std::numeric_limits<float>::quiet_NaN(),
+    const expression& upper = std::numeric_limits<float>::quiet_NaN()
+);
+} // namespace surfio::irap
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "io_options.h"
 #include "irap.h"
 #include <filesystem>
+#include <functional>
 #include <span>
 #include <string_view>
 
@@ -11,8 +13,24 @@ inline size_t column_major_to_row_major_index(size_t idx, size_t nrow, size_t nc
   return idx / nrow + (idx % nrow) * ncol;
 }
 
-irap from_ascii_file(const std::filesystem::path& file);
+irap from_ascii_file(const std::filesystem::path& file, const io_options& options = {});
 irap from_ascii_string(std::string_view buffer);
-irap from_binary_file(const std::filesystem::path& file);
+irap from_binary_file(const std::filesystem::path& file, const io_options& options = {});
 irap from_binary_buffer(std::span<const char> buffer);
+
+using header_callback = std::function<void(const irap_header& header)>;
+using block_callback = std::function<void(size_t offset, std::span<const float> block)>;
+
+// Read a file without storing all of its values. on_header is called with the header,
+// then on_block with consecutive blocks of at most block_rows rows (ncol values each) in
+// file order, where value number offset + k is at column (offset + k) % ncol and
+// row (offset + k) / ncol.
+void read_ascii_file_blocks(
+    const std::filesystem::path& file, size_t block_rows, const header_callback& on_header,
+    const block_callback& on_block, const io_options& options = {}
+);
+void read_binary_file_blocks(
+    const std::filesystem::path& file, size_t block_rows, const header_callback& on_header,
+    const block_callback& on_block, const io_options& options = {}
+);
 } // namespace surfio::irap
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "io_options.h"
+#include "irap.h"
+#include "irap_export.h"
+#include <filesystem>
+#include <vector>
+
+namespace surfio::irap {
+// How the values of a 2x2 block are combined into one value on the next level.
+// Undefined (NaN) values are ignored, and a block of only undefined values is undefined.
+enum class pyramid_reduction { mean, min, max };
+
+// Decimate a surface into levels 2x, 4x, ..., 2^levels x coarser than the input.
+// Each level has the same origin and rotation as the input, with xinc and yinc scaled
+// by the decimation factor. All levels are computed in one pass over the input.
+std::vector<irap> make_pyramid(
+    const irap_header& header, surf_span values, size_t levels,
+    pyramid_reduction reduction = pyramid_reduction::mean
+);
+std::vector<irap> make_pyramid(
+    const irap& data, size_t levels, pyramid_reduction reduction = pyramid_reduction::mean
+);
+
+// Build the pyramid while the file is read, without storing the full resolution surface
+std::vector<irap> pyramid_from_ascii_file(
+    const std::filesystem::path& file, size_t levels,
+    pyramid_reduction reduction = pyramid_reduction::mean, const io_options& options = {}
+);
+std::vector<irap> pyramid_from_binary_file(
+    const std::filesystem::path& file, size_t levels,
+    pyramid_reduction reduction = pyramid_reduction::mean, const io_options& options = {}
+);
+} // namespace surfio::irap
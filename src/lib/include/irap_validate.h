@@ -0,0 +1,41 @@
+#pragma once
+
+#include "io_options.h"
+#include "irap.h"
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace surfio::irap {
+struct validation_report {
+  // True if the input is well-formed and holds exactly ncol * nrow values
+  bool valid = true;
+  // Description of the first problem found. Empty when valid
+  std::string error;
+  // Byte offset of the first problem found
+  std::optional<size_t> first_bad_offset;
+  // Chunk guards at first_bad_offset, for binary guard mismatches only
+  std::optional<int32_t> expected_guard;
+  std::optional<int32_t> actual_guard;
+  // Header of the input, if it could be read
+  std::optional<irap_header> header;
+  // ncol * nrow as declared in the header
+  size_t expected_values = 0;
+  // Number of values found in the well-formed part of the input
+  size_t value_count = 0;
+  // Number of those values that are undefined
+  size_t undef_count = 0;
+};
+
+// Check the structure of irap files without materializing the values.
+// The scan of large inputs is split over the hardware threads.
+validation_report
+validate_ascii_file(const std::filesystem::path& file, const io_options& options = {});
+validation_report validate_ascii_string(std::string_view buffer);
+validation_report
+validate_binary_file(const std::filesystem::path& file, const io_options& options = {});
+validation_report validate_binary_buffer(std::span<const char> buffer);
+} // namespace surfio::irap
@@ -1,3 +1,4 @@
+#include "export_block/export_block.h"
 #include "include/irap.h"
 #include "include/irap_export.h"
 #include <cmath>
@@ -5,14 +6,16 @@
 #include <format>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <ostream>
 #include <sstream>
+#include <string>
 
 namespace fs = std::filesystem;
 
 namespace surfio::irap {
 static const auto id = std::format("{} ", irap_header::id);
-static auto UNDEF_MAP_IRAP_STRING = std::format("{:f}", UNDEF_MAP_IRAP_ASCII);
+static const auto UNDEF_MAP_IRAP_STRING = std::format("{:f}", UNDEF_MAP_IRAP_ASCII);
 
 void write_header_ascii(const irap_header& header, std::ostream& out) {
   out << std::setprecision(6) << std::fixed << std::showpoint;
@@ -22,24 +25,54 @@ void write_header_ascii(const irap_header& header, std::ostream& out) {
   out << "0 0 0 0 0 0 0\n";
 }
 
+// Append v, followed by a newline when it ends a line, where values_on_line is the
+// number of values already on the current line
+void append_value_ascii(std::string& out, float v, size_t& values_on_line) {
+  if (std::isnan(v))
+    out += UNDEF_MAP_IRAP_STRING;
+  else
+    std::format_to(std::back_inserter(out), "{:f}", v);
+
+  ++values_on_line %= MAX_PER_LINE;
+  out += values_on_line ? ' ' : '\n';
+}
+
 void write_values_ascii(surf_span values, std::ostream& out) {
-  out << std::setprecision(4) << std::fixed << std::showpoint;
-  size_t values_on_current_line = 0;
+  size_t values_on_line = 0;
   auto rows = values.extent(0);
   auto cols = values.extent(1);
+  std::string buffer;
+  size_t in_block = 0;
+  auto flush = [&] {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+    in_block = 0;
+  };
   for (size_t j = 0; j < cols; j++) {
     for (size_t i = 0; i < rows; i++) {
 #if __cpp_multidimensional_subscript
-      auto v = values[i, j];
+      append_value_ascii(buffer, values[i, j], values_on_line);
 #else
-      auto v = values(i, j);
+      append_value_ascii(buffer, values(i, j), values_on_line);
 #endif
-      out << (std::isnan(v) ? UNDEF_MAP_IRAP_STRING : std::format("{:f}", v));
-
-      ++values_on_current_line %= MAX_PER_LINE;
-      out << (values_on_current_line ? " " : "\n");
+      if (++in_block == WRITE_BLOCK_SIZE)
+        flush();
     }
   }
+  if (in_block)
+    flush();
+}
+
+void encode_header_ascii(const irap_header& header, std::string& out) {
+  std::ostringstream stream;
+  write_header_ascii(header, stream);
+  out += stream.view();
+}
+
+void encode_values_ascii(std::span<const float> block, size_t offset, std::string& out) {
+  auto values_on_line = offset % MAX_PER_LINE;
+  for (auto v : block)
+    append_value_ascii(out, v, values_on_line);
 }
 
 void to_ascii_file(const fs::path& file, const irap_header& header, surf_span values) {
@@ -1,3 +1,4 @@
+#include "export_block/export_block.h"
 #include "include/irap.h"
 #include "include/irap_export.h"
 #include <algorithm>
@@ -8,6 +9,8 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 
 namespace fs = std::filesystem;
 
@@ -40,45 +43,86 @@ void write_header_binary(const irap_header& header, std::ostream& out) {
   );
 }
 
+// Position in the chunks of the values, which hold PER_LINE_BINARY values between two
+// guards with their length in bytes, except the last chunk which may be shorter
+struct chunk_position {
+  // values left to write, including those of the current chunk
+  size_t remaining;
+  size_t written_on_line;
+  size_t chunk_length;
+
+  // Position of the value at offset, where nvalues is the number of values in the surface
+  chunk_position(size_t offset, size_t nvalues)
+      : remaining(nvalues - offset), written_on_line(offset % PER_LINE_BINARY),
+        chunk_length(std::min(remaining + written_on_line, PER_LINE_BINARY)) {}
+};
+
+void write_value_binary(char*& bufptr, float v, chunk_position& pos) {
+  if (pos.written_on_line == 0) {
+    pos.chunk_length = std::min(pos.remaining, PER_LINE_BINARY);
+    write_32bit_binary_value(bufptr, pos.chunk_length * 4);
+  }
+
+  write_32bit_binary_value(bufptr, std::isnan(v) ? UNDEF_MAP_IRAP_BINARY : v);
+
+  --pos.remaining;
+  if (++pos.written_on_line == pos.chunk_length) {
+    write_32bit_binary_value(bufptr, pos.chunk_length * 4);
+    pos.written_on_line = 0;
+  }
+}
+
+// Bytes needed for count values, as a block has at most one more chunk than fits in it
+// and each chunk has two guards
+constexpr size_t encoded_size_binary(size_t count) {
+  return count * sizeof(float) + (count / PER_LINE_BINARY + 2) * 2 * sizeof(int32_t);
+}
+
 void write_values_binary(surf_span values, std::ostream& out) {
-  size_t written_on_line = 0;
-  size_t chunk_length = 0;
+  auto pos = chunk_position(0, values.size());
   auto rows = values.extent(0);
   auto cols = values.extent(1);
-  auto remaining = values.size();
-  constexpr long CHUNK_SIZE = (PER_LINE_BINARY + 2) * sizeof(float);
-  char buf[CHUNK_SIZE * 10];
-  char* bufptr = buf;
+  std::string buffer(encoded_size_binary(WRITE_BLOCK_SIZE), '\0');
+  char* bufptr = buffer.data();
+  size_t in_block = 0;
+  auto flush = [&] {
+    out.write(buffer.data(), std::distance(buffer.data(), bufptr));
+    bufptr = buffer.data();
+    in_block = 0;
+  };
   for (size_t j = 0; j < cols; j++) {
     for (size_t i = 0; i < rows; i++) {
-      if (written_on_line == 0) {
-        chunk_length = std::min(remaining, PER_LINE_BINARY);
-        write_32bit_binary_value(bufptr, chunk_length * 4);
-      }
-
 #if __cpp_multidimensional_subscript
-      auto v = values[i, j];
+      write_value_binary(bufptr, values[i, j], pos);
 #else
-      auto v = values(i, j);
+      write_value_binary(bufptr, values(i, j), pos);
 #endif
-      write_32bit_binary_value(bufptr, std::isnan(v) ? UNDEF_MAP_IRAP_BINARY : v);
-
-      if (++written_on_line == chunk_length) {
-        write_32bit_binary_value(bufptr, chunk_length * 4);
-        written_on_line = 0;
-      }
-
-      if (auto bytes_written = std::distance(buf, bufptr);
-          sizeof(buf) - bytes_written < CHUNK_SIZE) {
-        out.write(buf, bytes_written);
-        bufptr = buf;
-      }
-
-      --remaining;
+      if (++in_block == WRITE_BLOCK_SIZE)
+        flush();
     }
   }
-  if (auto dist = std::distance(buf, bufptr); dist)
-    out.write(buf, dist);
+  if (in_block)
+    flush();
+}
+
+void encode_header_binary(const irap_header& header, std::string& out) {
+  std::ostringstream stream;
+  write_header_binary(header, stream);
+  out += stream.view();
+}
+
+void encode_values_binary(
+    std::span<const float> block, size_t offset, size_t nvalues, std::string& out
+) {
+  if (block.size() > nvalues || offset > nvalues - block.size())
+    throw std::domain_error("Block exceeds the number of values declared in header");
+  auto pos = chunk_position(offset, nvalues);
+  const auto start = out.size();
+  out.resize(start + encoded_size_binary(block.size()));
+  char* bufptr = out.data() + start;
+  for (auto v : block)
+    write_value_binary(bufptr, v, pos);
+  out.resize(static_cast<size_t>(bufptr - out.data()));
 }
 
 void to_binary_file(const fs::path& file, const irap_header& header, surf_span values) {
@@ -0,0 +1,378 @@
+#include "include/irap_expression.h"
+#include "parallel/parallel_for.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace surfio::irap {
+// Number of values each operation is applied to at a time. Small enough for the
+// intermediate results of an expression to stay in cache.
+constexpr size_t BLOCK_SIZE = 2048;
+constexpr size_t MIN_BLOCKS_PER_THREAD = 16;
+constexpr float NaN = std::numeric_limits<float>::quiet_NaN();
+
+struct expression::node {
+  enum class kind { scalar, surface, operation };
+  kind type;
+  float value = 0.f;
+  const float* data = nullptr;
+  expression_op op = expression_op::add;
+  std::vector<std::shared_ptr<const node>> operands = {};
+
+  ~node();
+};
+
+// Nodes no longer used by anything else are unlinked from their operands one at a
+// time, as destroying a deep tree recursively would overflow the stack.
+expression::node::~node() {
+  auto pending = std::move(operands);
+  while (!pending.empty()) {
+    auto n = std::move(pending.back());
+    pending.pop_back();
+    if (n.use_count() == 1)
+      for (auto& operand : const_cast<node&>(*n).operands)
+        pending.push_back(std::move(operand));
+  }
+}
+
+size_t arity(expression_op op) {
+  switch (op) {
+  case expression_op::negate:
+  case expression_op::abs:
+  case expression_op::logical_not:
+    return 1;
+  case expression_op::where:
+  case expression_op::clip:
+    return 3;
+  default:
+    return 2;
+  }
+}
+
+void check_compatible(const irap_header& lhs, const irap_header& rhs) {
+  auto check = [](std::string_view name, auto l, auto r) {
+    if (l != r)
+      throw std::domain_error(
+          std::format("Surfaces in expression are on different grids, {}: {} != {}", name, l, r)
+      );
+  };
+  check("ncol", lhs.ncol, rhs.ncol);
+  check("nrow", lhs.nrow, rhs.nrow);
+  check("xori", lhs.xori, rhs.xori);
+  check("yori", lhs.yori, rhs.yori);
+  check("xinc", lhs.xinc, rhs.xinc);
+  check("yinc", lhs.yinc, rhs.yinc);
+  check("rot", lhs.rot, rhs.rot);
+}
+
+expression::expression(float value)
+    : root(std::make_shared<node>(node{.type = node::kind::scalar, .value = value})) {}
+
+expression::expression(const irap_header& header, surf_span values) : grid(header) {
+  if (values.extent(0) != size_t(header.ncol) || values.extent(1) != size_t(header.nrow))
+    throw std::domain_error("Dimensions of values do not match ncol and nrow of header");
+  root = std::make_shared<node>(node{.type = node::kind::surface, .data = values.data_handle()});
+}
+
+expression::expression(const irap& data)
+    : expression(data.header, surf_span{data.values.data(), data.header.ncol, data.header.nrow}) {}
+
+expression::expression(expression_op op, std::initializer_list<expression> operands) {
+  if (operands.size() != arity(op))
+    throw std::domain_error("Wrong number of operands for expression");
+  auto n = node{.type = node::kind::operation, .op = op};
+  for (const auto& operand : operands) {
+    n.operands.push_back(operand.root);
+    if (!operand.grid)
+      continue;
+    if (grid)
+      check_compatible(*grid, *operand.grid);
+    else
+      grid = operand.grid;
+  }
+  root = std::make_shared<node>(std::move(n));
+}
+
+float truth(bool value) { return value ? 1.f : 0.f; }
+float nan_aware_min(float x, float y) { return std::isnan(x) ? y : (y < x ? y : x); }
+float nan_aware_max(float x, float y) { return std::isnan(x) ? y : (y > x ? y : x); }
+
+template <typename Compare> auto comparison(Compare compare) {
+  return [compare](float x, float y) {
+    return std::isnan(x) || std::isnan(y) ? NaN : truth(compare(x, y));
+  };
+}
+
+template <typename F> void map(float* out, size_t n, F f, const float* a) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = f(a[i]);
+}
+
+template <typename F> void map(float* out, size_t n, F f, const float* a, const float* b) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = f(a[i], b[i]);
+}
+
+template <typename F>
+void map(float* out, size_t n, F f, const float* a, const float* b, const float* c) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = f(a[i], b[i], c[i]);
+}
+
+void apply(expression_op op, float* out, size_t n, const std::array<const float*, 3>& args) {
+  auto [a, b, c] = args;
+  switch (op) {
+  case expression_op::negate:
+    return map(out, n, [](float x) { return -x; }, a);
+  case expression_op::abs:
+    return map(out, n, [](float x) { return std::abs(x); }, a);
+  case expression_op::logical_not:
+    return map(out, n, [](float x) { return std::isnan(x) ? NaN : truth(x == 0.f); }, a);
+  case expression_op::add:
+    return map(out, n, [](float x, float y) { return x + y; }, a, b);
+  case expression_op::subtract:
+    return map(out, n, [](float x, float y) { return x - y; }, a, b);
+  case expression_op::multiply:
+    return map(out, n, [](float x, float y) { return x * y; }, a, b);
+  case expression_op::divide:
+    return map(out, n, [](float x, float y) { return x / y; }, a, b);
+  case expression_op::less:
+    return map(out, n, comparison(std::less<>{}), a, b);
+  case expression_op::less_equal:
+    return map(out, n, comparison(std::less_equal<>{}), a, b);
+  case expression_op::greater:
+    return map(out, n, comparison(std::greater<>{}), a, b);
+  case expression_op::greater_equal:
+    return map(out, n, comparison(std::greater_equal<>{}), a, b);
+  case expression_op::logical_and:
+    return map(out, n, comparison([](float x, float y) { return x != 0.f && y != 0.f; }), a, b);
+  case expression_op::logical_or:
+    return map(out, n, comparison([](float x, float y) { return x != 0.f || y != 0.f; }), a, b);
+  case expression_op::fmin:
+    return map(out, n, nan_aware_min, a, b);
+  case expression_op::fmax:
+    return map(out, n, nan_aware_max, a, b);
+  case expression_op::where:
+    return map(
+        out, n,
+        [](float condition, float x, float y) {
+          return std::isnan(condition) ? NaN : condition != 0.f ? x : y;
+        },
+        a, b, c
+    );
+  case expression_op::clip:
+    return map(
+        out, n,
+        [](float x, float lower, float upper) {
+          return std::isnan(x) ? x : nan_aware_min(nan_aware_max(x, lower), upper);
+        },
+        a, b, c
+    );
+  }
+}
+
+irap expression::evaluate() const {
+  if (!grid)
+    throw std::domain_error("Expression contains no surface");
+  auto result = irap{
+      .header = *grid, .values = std::vector<float>(size_t(grid->ncol) * size_t(grid->nrow))
+  };
+  evaluate(result.values);
+  return result;
+}
+
+void expression::evaluate(std::span<float> out) const {
+  if (!grid)
+    throw std::domain_error("Expression contains no surface");
+  const size_t nvalues = size_t(grid->ncol) * size_t(grid->nrow);
+  if (out.size() != nvalues)
+    throw std::domain_error("Size of output does not match ncol and nrow of expression");
+
+  // The tree is flattened into a list of instructions in postorder, without recursion
+  // as trees can be deep. Shared subexpressions are only computed once.
+  struct slot {
+    enum class kind { scalar, surface, reg };
+    kind type;
+    size_t index;
+  };
+  struct instruction {
+    expression_op op;
+    std::array<slot, 3> args;
+  };
+  std::vector<float> scalars;
+  std::unordered_map<uint32_t, size_t> scalar_slots;
+  std::vector<const float*> surfaces;
+  std::vector<instruction> program;
+  std::unordered_map<const node*, slot> slots;
+  std::vector<std::pair<const node*, bool>> stack{{root.get(), false}};
+  while (!stack.empty()) {
+    auto [n, expanded] = stack.back();
+    if (slots.contains(n)) {
+      stack.pop_back();
+      continue;
+    }
+    if (n->type == node::kind::operation && !expanded) {
+      // compile the operands first, in order
+      stack.back().second = true;
+      for (auto it = n->operands.rbegin(); it != n->operands.rend(); ++it)
+        stack.emplace_back(it->get(), false);
+      continue;
+    }
+    stack.pop_back();
+    slot result;
+    switch (n->type) {
+    case node::kind::scalar: {
+      // each distinct scalar is filled into a block once
+      auto [it, inserted] =
+          scalar_slots.try_emplace(std::bit_cast<uint32_t>(n->value), scalars.size());
+      if (inserted)
+        scalars.push_back(n->value);
+      result = {slot::kind::scalar, it->second};
+      break;
+    }
+    case node::kind::surface:
+      result = {slot::kind::surface, surfaces.size()};
+      surfaces.push_back(n->data);
+      break;
+    case node::kind::operation: {
+      auto ins = instruction{.op = n->op, .args = {}};
+      for (size_t i = 0; i < n->operands.size(); ++i)
+        ins.args[i] = slots.at(n->operands[i].get());
+      result = {slot::kind::reg, program.size()};
+      program.push_back(ins);
+      break;
+    }
+    }
+    slots.emplace(n, result);
+  }
+  const auto result = slots.at(root.get());
+
+  // Each instruction writes to a register, which is reused once the last instruction
+  // reading it is done. The operations work elementwise, so an instruction can write
+  // to the register of one of its own operands.
+  auto last_use = std::vector<size_t>(program.size());
+  for (size_t i = 0; i < program.size(); ++i)
+    for (const auto& arg : program[i].args)
+      if (arg.type == slot::kind::reg)
+        last_use[arg.index] = i;
+  auto registers_of = std::vector<size_t>(program.size());
+  std::vector<size_t> free_registers;
+  size_t nregisters = 0;
+  for (size_t i = 0; i < program.size(); ++i) {
+    for (auto& arg : program[i].args)
+      if (arg.type == slot::kind::reg) {
+        if (last_use[arg.index] == i) {
+          free_registers.push_back(registers_of[arg.index]);
+          // an operand used twice by this instruction is only released once
+          last_use[arg.index] = program.size();
+        }
+        arg.index = registers_of[arg.index];
+      }
+    if (free_registers.empty()) {
+      registers_of[i] = nregisters++;
+    } else {
+      registers_of[i] = free_registers.back();
+      free_registers.pop_back();
+    }
+  }
+
+  const auto nblocks = (nvalues + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  parallel::parallel_for(
+      nblocks,
+      [&](size_t first, size_t last) {
+        auto registers = std::vector<float>(nregisters * BLOCK_SIZE);
+        auto scalar_blocks = std::vector<float>(scalars.size() * BLOCK_SIZE);
+        for (size_t s = 0; s < scalars.size(); ++s)
+          std::fill_n(scalar_blocks.begin() + s * BLOCK_SIZE, BLOCK_SIZE, scalars[s]);
+
+        for (auto b = first; b < last; ++b) {
+          const size_t start = b * BLOCK_SIZE;
+          const size_t n = std::min(BLOCK_SIZE, nvalues - start);
+          auto resolve = [&](slot s) -> const float* {
+            switch (s.type) {
+            case slot::kind::scalar:
+              return scalar_blocks.data() + s.index * BLOCK_SIZE;
+            case slot::kind::surface:
+              return surfaces[s.index] + start;
+            default:
+              return registers.data() + s.index * BLOCK_SIZE;
+            }
+          };
+          // the last instruction computes the root, and writes straight to the output
+          for (size_t i = 0; i < program.size(); ++i) {
+            auto dest = i + 1 == program.size()
+                            ? out.data() + start
+                            : registers.data() + registers_of[i] * BLOCK_SIZE;
+            const auto& args = program[i].args;
+            apply(
+                program[i].op, dest, n, {resolve(args[0]), resolve(args[1]), resolve(args[2])}
+            );
+          }
+          if (result.type != slot::kind::reg)
+            std::copy_n(resolve(result), n, out.data() + start);
+        }
+      },
+      MIN_BLOCKS_PER_THREAD
+  );
+}
+
+expression operator-(const expression& operand) { return {expression_op::negate, {operand}}; }
+expression operator+(const expression& lhs, const expression& rhs) {
+  return {expression_op::add, {lhs, rhs}};
+}
+expression operator-(const expression& lhs, const expression& rhs) {
+  return {expression_op::subtract, {lhs, rhs}};
+}
+expression operator*(const expression& lhs, const expression& rhs) {
+  return {expression_op::multiply, {lhs, rhs}};
+}
+expression operator/(const expression& lhs, const expression& rhs) {
+  return {expression_op::divide, {lhs, rhs}};
+}
+expression operator<(const expression& lhs, const expression& rhs) {
+  return {expression_op::less, {lhs, rhs}};
+}
+expression operator<=(const expression& lhs, const expression& rhs) {
+  return {expression_op::less_equal, {lhs, rhs}};
+}
+expression operator>(const expression& lhs, const expression& rhs) {
+  return {expression_op::greater, {lhs, rhs}};
+}
+expression operator>=(const expression& lhs, const expression& rhs) {
+  return {expression_op::greater_equal, {lhs, rhs}};
+}
+
+expression abs(const expression& operand) { return {expression_op::abs, {operand}}; }
+expression logical_not(const expression& operand) {
+  return {expression_op::logical_not, {operand}};
+}
+expression logical_and(const expression& lhs, const expression& rhs) {
+  return {expression_op::logical_and, {lhs, rhs}};
+}
+expression logical_or(const expression& lhs, const expression& rhs) {
+  return {expression_op::logical_or, {lhs, rhs}};
+}
+expression fmin(const expression& lhs, const expression& rhs) {
+  return {expression_op::fmin, {lhs, rhs}};
+}
+expression fmax(const expression& lhs, const expression& rhs) {
+  return {expression_op::fmax, {lhs, rhs}};
+}
+expression where(
+    const expression& condition, const expression& if_true, const expression& if_false
+) {
+  return {expression_op::where, {condition, if_true, if_false}};
+}
+expression clip(const expression& value, const expression& lower, const expression& upper) {
+  return {expression_op::clip, {value, lower, upper}};
+}
+} // namespace surfio::irap
@@ -1,16 +1,19 @@
 #include "include/irap_import.h"
+#include "include/irap_validate.h"
 #include "mmap_wrapper/mmap_wrapper.h"
+#include "parallel/parallel_for.h"
 #include "parse_number/parse_number.h"
 #include <algorithm>
+#include <cmath>
 #include <filesystem>
 #include <format>
+#include <limits>
 
 namespace fs = std::filesystem;
 
 namespace surfio::irap {
-auto locale = std::locale("C");
-auto& facet = std::use_facet<std::ctype<char>>(locale);
-auto is_space = [](char ch) { return facet.is(std::ctype_base::space, ch); };
+// whitespace as classified by the "C" locale
+constexpr bool is_space(char ch) { return ch == ' ' || (ch >= '\t' && ch <= '\r'); }
 
 template <typename T, typename... U>
 const char* read_headers(const char* start, const char* end, T& arg, U&... args) {
@@ -52,16 +55,41 @@ std::tuple<irap_header, const char*> get_header(const char* start, const char* e
   return {head, ptr};
 }
 
-std::vector<float> get_values(const char* start, const char* end, size_t ncol, size_t nrow) {
-  const size_t nvalues = ncol * nrow;
+void check_value_count(const char* start, const char* end, size_t nvalues) {
   if (static_cast<size_t>(end - start) / 4 < nvalues)
     throw std::length_error("ncol and nrow declared in header exceed length of input");
-  auto values = std::vector<float>(nvalues);
-  for (auto i = 0u; i < nvalues; ++i) {
-    float value;
+}
+
+enum class token { value, end, invalid };
 
-    start = std::find_if_not(start, end, is_space);
-    if (start == end)
+// Skip whitespace and parse the value at ptr, moving ptr past it. Undefined values are
+// NaN. At the end of the input or on a value that can not be parsed, ptr is left at
+// where the value should start.
+token next_value(const char*& ptr, const char* end, float& value) {
+  ptr = std::find_if_not(ptr, end, is_space);
+  if (ptr == end)
+    return token::end;
+
+  auto result = parse_number::from_chars(ptr, end, value);
+  if (result.ec != std::errc())
+    return token::invalid;
+  ptr = result.ptr;
+
+  if (value >= UNDEF_MAP_IRAP_ASCII)
+    value = std::numeric_limits<float>::quiet_NaN();
+
+  return token::value;
+}
+
+// Parse nvalues values in file order, and pass each of them to store(i, value)
+template <typename F>
+void decode_values(const char* start, const char* end, size_t nvalues, F&& store) {
+  for (size_t i = 0; i < nvalues; ++i) {
+    float value;
+    switch (next_value(start, end, value)) {
+    case token::value:
+      break;
+    case token::end:
       throw std::length_error(
           std::format(
               "End of file reached before reading all values. Expected: {}, "
@@ -69,24 +97,28 @@ std::vector<float> get_values(const char* start, const char* end, size_t ncol, s
               nvalues, i
           )
       );
-
-    auto result = parse_number::from_chars(start, end, value);
-    start = result.ptr;
-    if (result.ec != std::errc())
+    case token::invalid:
       throw std::domain_error("Failed to read values during Irap ASCII import.");
+    }
 
-    if (value >= UNDEF_MAP_IRAP_ASCII)
-      value = std::numeric_limits<float>::quiet_NaN();
+    store(i, value);
+  }
+}
 
+std::vector<float> get_values(const char* start, const char* end, size_t ncol, size_t nrow) {
+  const size_t nvalues = ncol * nrow;
+  check_value_count(start, end, nvalues);
+  auto values = std::vector<float>(nvalues);
+  decode_values(start, end, nvalues, [&](size_t i, float value) {
     auto ic = column_major_to_row_major_index(i, ncol, nrow);
     values[ic] = value;
-  }
+  });
 
   return values;
 }
 
-irap from_ascii_file(const fs::path& file) {
-  auto buffer = mmap::mmap_file(file);
+irap from_ascii_file(const fs::path& file, const io_options& options) {
+  auto buffer = mmap::input_file(file, options);
 
   auto [head, ptr] = get_header(buffer.begin(), buffer.end());
   auto values = get_values(ptr, buffer.end(), head.ncol, head.nrow);
@@ -102,4 +134,127 @@ irap from_ascii_string(std::string_view buffer) {
 
   return {.header = std::move(head), .values = std::move(values)};
 }
+
+void read_ascii_file_blocks(
+    const fs::path& file, size_t block_rows, const header_callback& on_header,
+    const block_callback& on_block, const io_options& options
+) {
+  if (block_rows == 0)
+    throw std::domain_error("Number of rows per block must be positive");
+  auto buffer = mmap::input_file(file, options);
+  auto [head, ptr] = get_header(buffer.begin(), buffer.end());
+  on_header(head);
+
+  const size_t ncol = head.ncol;
+  const size_t nvalues = ncol * size_t(head.nrow);
+  check_value_count(ptr, buffer.end(), nvalues);
+  auto block = std::vector<float>(std::min(block_rows * ncol, nvalues));
+  size_t filled = 0;
+  decode_values(ptr, buffer.end(), nvalues, [&](size_t i, float value) {
+    block[filled] = value;
+    if (++filled == block.size() || i + 1 == nvalues) {
+      on_block(i + 1 - filled, {block.data(), filled});
+      filled = 0;
+    }
+  });
+}
+
+struct value_scan {
+  size_t count = 0;
+  size_t undef_count = 0;
+  // where the scan stopped
+  const char* ptr;
+  bool failed = false;
+};
+
+// Tokenize and parse up to max_values values the same way get_values does,
+// without storing them.
+value_scan scan_values(const char* start, const char* end, size_t max_values) {
+  value_scan scan{.ptr = start};
+  while (scan.count < max_values) {
+    float value;
+    auto t = next_value(scan.ptr, end, value);
+    if (t != token::value) {
+      scan.failed = t == token::invalid;
+      break;
+    }
+    ++scan.count;
+    scan.undef_count += std::isnan(value);
+  }
+  return scan;
+}
+
+validation_report validate_ascii(std::string_view buffer) {
+  validation_report report;
+  auto fail = [&](const char* at, std::string error) {
+    report.valid = false;
+    report.first_bad_offset = at - buffer.data();
+    report.error = std::move(error);
+  };
+
+  auto end = buffer.data() + buffer.size();
+  const char* start;
+  try {
+    std::tie(report.header, start) = get_header(buffer.data(), end);
+  } catch (const std::exception& e) {
+    fail(buffer.data(), e.what());
+    return report;
+  }
+  report.expected_values = size_t(report.header->ncol) * size_t(report.header->nrow);
+
+  // Split the values into one segment per thread. Segments start on whitespace, so
+  // no value is cut in two and each segment can be tokenized on its own.
+  const auto nsegments = parallel::part_count(end - start, parallel::MIN_SEGMENT_BYTES);
+  auto bounds = std::vector<const char*>(nsegments + 1, end);
+  bounds[0] = start;
+  for (size_t s = 1; s < nsegments; ++s)
+    bounds[s] = std::find_if(
+        std::max(start + (end - start) * s / nsegments, bounds[s - 1]), end, is_space
+    );
+
+  auto scans = std::vector<value_scan>(nsegments);
+  parallel::parallel_for(nsegments, [&](size_t first, size_t last) {
+    for (auto s = first; s < last; ++s)
+      scans[s] = scan_values(bounds[s], bounds[s + 1], std::numeric_limits<size_t>::max());
+  });
+
+  for (size_t s = 0; s < nsegments; ++s) {
+    if (report.value_count + scans[s].count > report.expected_values) {
+      // Rescan the segment to find where the surplus values start
+      auto scan =
+          scan_values(bounds[s], bounds[s + 1], report.expected_values - report.value_count);
+      report.value_count += scan.count;
+      report.undef_count += scan.undef_count;
+      fail(
+          std::find_if_not(scan.ptr, end, is_space),
+          std::format("More values than the {} declared in header", report.expected_values)
+      );
+      return report;
+    }
+    report.value_count += scans[s].count;
+    report.undef_count += scans[s].undef_count;
+    if (scans[s].failed) {
+      fail(scans[s].ptr, "Failed to read values during Irap ASCII validation.");
+      return report;
+    }
+  }
+
+  if (report.value_count < report.expected_values)
+    fail(
+        end,
+        std::format(
+            "End of file reached before reading all values. Expected: {}, got {}",
+            report.expected_values, report.value_count
+        )
+    );
+
+  return report;
+}
+
+validation_report validate_ascii_file(const fs::path& file, const io_options& options) {
+  auto buffer = mmap::input_file(file, options);
+  return validate_ascii({buffer.begin(), buffer.end()});
+}
+
+validation_report validate_ascii_string(std::string_view buffer) { return validate_ascii(buffer); }
 } // namespace surfio::irap
@@ -1,12 +1,16 @@
 #include "include/irap.h"
 #include "include/irap_import.h"
+#include "include/irap_validate.h"
 #include "mmap_wrapper/mmap_wrapper.h"
+#include "parallel/parallel_for.h"
 #include <algorithm>
 #include <array>
 #include <bit>
 #include <cstdint>
 #include <filesystem>
 #include <format>
+#include <iterator>
+#include <limits>
 #include <ranges>
 #include <span>
 #include <stdexcept>
@@ -92,33 +96,47 @@ std::tuple<irap_header, const char*> get_header_binary(std::span<const char> buf
   return {header, ptr};
 }
 
-std::vector<float> get_values_binary(const char* start, const char* end, size_t ncol, size_t nrow) {
-  const size_t nvalues = ncol * nrow;
+void check_value_count_binary(const char* start, const char* end, size_t nvalues) {
   if (static_cast<size_t>(end - start) / 4 < nvalues)
     throw std::length_error("ncol and nrow declared in header exceed length of input");
-  auto values = std::vector<float>(nvalues);
+}
+
+// Read nvalues values in file order, and pass each of them to store(i, value)
+template <typename F>
+void decode_values_binary(const char* start, const char* end, size_t nvalues, F&& store) {
   auto ptr = start;
 
   // chunk guards tell you how many bytes there are to read in a chunk.
   // there is a matching guard at the end of each chunk.
   int32_t chunk_size;
-  for (auto i = 0u; i < nvalues;) {
+  for (size_t i = 0; i < nvalues;) {
     ptr = read_32bit_value(ptr, end, chunk_size);
     size_t values_left = chunk_size / 4; // each value is 32 bit
+    if (chunk_size < 0 || values_left > nvalues - i)
+      throw std::domain_error("Chunk exceeds the number of values declared in header");
     for (auto j = 0u; j < values_left; ++j, ++i) {
       float value;
       ptr = read_32bit_value(ptr, end, value);
-      auto ic = column_major_to_row_major_index(i, ncol, nrow);
-      values[ic] = value < UNDEF_MAP_IRAP_BINARY ? value : std::numeric_limits<float>::quiet_NaN();
+      store(i, value < UNDEF_MAP_IRAP_BINARY ? value : std::numeric_limits<float>::quiet_NaN());
     }
     ptr = read_and_check_value(ptr, end, chunk_size, "Block size mismatch");
   }
+}
+
+std::vector<float> get_values_binary(const char* start, const char* end, size_t ncol, size_t nrow) {
+  const size_t nvalues = ncol * nrow;
+  check_value_count_binary(start, end, nvalues);
+  auto values = std::vector<float>(nvalues);
+  decode_values_binary(start, end, nvalues, [&](size_t i, float value) {
+    auto ic = column_major_to_row_major_index(i, ncol, nrow);
+    values[ic] = value;
+  });
 
   return values;
 }
 
-irap from_binary_file(const fs::path& file) {
-  auto buffer = mmap::mmap_file(file);
+irap from_binary_file(const fs::path& file, const io_options& options) {
+  auto buffer = mmap::input_file(file, options);
   auto [header, ptr] = get_header_binary(buffer);
   auto values = get_values_binary(ptr, buffer.end(), header.ncol, header.nrow);
 
@@ -132,4 +150,152 @@ irap from_binary_buffer(std::span<const char> buffer) {
 
   return {.header = header, .values = std::move(values)};
 }
+
+void read_binary_file_blocks(
+    const fs::path& file, size_t block_rows, const header_callback& on_header,
+    const block_callback& on_block, const io_options& options
+) {
+  if (block_rows == 0)
+    throw std::domain_error("Number of rows per block must be positive");
+  auto buffer = mmap::input_file(file, options);
+  auto [header, ptr] = get_header_binary(buffer);
+  on_header(header);
+
+  const size_t ncol = header.ncol;
+  const size_t nvalues = ncol * size_t(header.nrow);
+  check_value_count_binary(ptr, buffer.end(), nvalues);
+  auto block = std::vector<float>(std::min(block_rows * ncol, nvalues));
+  size_t filled = 0;
+  decode_values_binary(ptr, buffer.end(), nvalues, [&](size_t i, float value) {
+    block[filled] = value;
+    if (++filled == block.size() || i + 1 == nvalues) {
+      on_block(i + 1 - filled, {block.data(), filled});
+      filled = 0;
+    }
+  });
+}
+
+validation_report validate_binary(std::span<const char> buffer) {
+  validation_report report;
+  auto fail = [&](const char* at, std::string error) {
+    report.valid = false;
+    report.first_bad_offset = at - buffer.data();
+    report.error = std::move(error);
+  };
+
+  const char* start;
+  try {
+    std::tie(report.header, start) = get_header_binary(buffer);
+  } catch (const std::exception& e) {
+    fail(buffer.data(), e.what());
+    return report;
+  }
+  auto end = buffer.data() + buffer.size();
+  report.expected_values = size_t(report.header->ncol) * size_t(report.header->nrow);
+
+  // Hop from guard to guard to find where the chunks are. This is the only part
+  // that has to be sequential, and it splits the chunks into one segment per thread.
+  struct segment {
+    const char* begin;
+    size_t first_value;
+  };
+  const auto nsegments = parallel::part_count(end - start, parallel::MIN_SEGMENT_BYTES);
+  auto segments = std::vector<segment>{{start, 0}};
+  auto ptr = start;
+  size_t count = 0;
+  while (count < report.expected_values) {
+    if (end - ptr < 4) {
+      fail(ptr, "End of file reached unexpectedly");
+      break;
+    }
+    int32_t chunk_size;
+    read_32bit_value(ptr, end, chunk_size);
+    if (chunk_size <= 0 || chunk_size % 4 != 0) {
+      fail(ptr, std::format("Incorrect chunk size: {}", chunk_size));
+      report.actual_guard = chunk_size;
+      break;
+    }
+    if (size_t(chunk_size / 4) > report.expected_values - count) {
+      fail(ptr, "Chunk exceeds the number of values declared in header");
+      report.actual_guard = chunk_size;
+      break;
+    }
+    if (end - ptr < chunk_size + 8) {
+      fail(ptr, "End of file reached unexpectedly");
+      break;
+    }
+    ptr += chunk_size + 8;
+    count += chunk_size / 4;
+    if (count * nsegments >= segments.size() * report.expected_values)
+      segments.push_back({ptr, count});
+  }
+  if (segments.back().begin != ptr)
+    segments.push_back({ptr, count});
+  if (report.valid && ptr != end)
+    fail(ptr, std::format("More values than the {} declared in header", report.expected_values));
+
+  // Check the trailing guards and count the values of each segment, up to the first
+  // chunk with a mismatching guard.
+  struct segment_result {
+    size_t value_count = 0;
+    size_t undef_count = 0;
+    const char* bad_guard = nullptr;
+    int32_t expected_guard = 0;
+    int32_t actual_guard = 0;
+  };
+  auto results = std::vector<segment_result>(segments.size() - 1);
+  parallel::parallel_for(results.size(), [&](size_t first, size_t last) {
+    for (auto s = first; s < last; ++s) {
+      auto& result = results[s];
+      for (auto p = segments[s].begin; p < segments[s + 1].begin;) {
+        int32_t chunk_size;
+        p = read_32bit_value(p, end, chunk_size);
+        size_t chunk_undef_count = 0;
+        for (auto v = 0; v < chunk_size / 4; ++v) {
+          float value;
+          p = read_32bit_value(p, end, value);
+          chunk_undef_count += !(value < UNDEF_MAP_IRAP_BINARY);
+        }
+        int32_t trailing;
+        read_32bit_value(p, end, trailing);
+        if (trailing != chunk_size) {
+          result.bad_guard = p;
+          result.expected_guard = chunk_size;
+          result.actual_guard = trailing;
+          break;
+        }
+        p += 4;
+        result.value_count += chunk_size / 4;
+        result.undef_count += chunk_undef_count;
+      }
+    }
+  });
+
+  // All segments lie before the point where the hop stopped, and they are in file
+  // order, so the first mismatching guard is the earliest problem in the input. The
+  // values after it, in its segment or later ones, are not part of the well-formed
+  // input and are not counted.
+  auto bad = std::ranges::find_if(results, [](auto& result) { return result.bad_guard; });
+  auto counted = bad == results.end() ? bad : std::next(bad);
+  for (auto& result : std::ranges::subrange(results.begin(), counted)) {
+    report.value_count += result.value_count;
+    report.undef_count += result.undef_count;
+  }
+  if (bad != results.end()) {
+    fail(bad->bad_guard, "Chunk size mismatch");
+    report.expected_guard = bad->expected_guard;
+    report.actual_guard = bad->actual_guard;
+  }
+
+  return report;
+}
+
+validation_report validate_binary_file(const fs::path& file, const io_options& options) {
+  auto buffer = mmap::input_file(file, options);
+  return validate_binary({buffer.begin(), buffer.end()});
+}
+
+validation_report validate_binary_buffer(std::span<const char> buffer) {
+  return validate_binary(buffer);
+}
 } // namespace surfio::irap
@@ -0,0 +1,274 @@
+#include "include/irap_import.h"
+#include "include/irap_pyramid.h"
+#include "parallel/parallel_for.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace surfio::irap {
+constexpr size_t MAX_PYRAMID_LEVELS = 31;
+// Levels up to this one are computed one tile at a time while the input is
+// traversed, a tile being the input cells that make up one cell on this level.
+// Coarser levels are computed afterwards from the small grid of tile results.
+constexpr size_t TILE_LEVELS = 7;
+// Rows of the input read at a time when building a pyramid from a file
+constexpr size_t MIN_BLOCK_ROWS = 128;
+// Input cells reduced by each thread at least, so threads are only started when
+// there is enough work to make up for it
+constexpr size_t MIN_CELLS_PER_THREAD = size_t{1} << 16;
+
+template <pyramid_reduction R> struct accumulator {
+  double value = 0.;
+  uint64_t count = 0;
+
+  void add(float v) {
+    if (!std::isnan(v))
+      merge({v, 1});
+  }
+
+  void merge(const accumulator& other) {
+    if (other.count == 0)
+      return;
+    if constexpr (R == pyramid_reduction::mean)
+      value += other.value;
+    else if constexpr (R == pyramid_reduction::min)
+      value = count ? std::min(value, other.value) : other.value;
+    else
+      value = count ? std::max(value, other.value) : other.value;
+    count += other.count;
+  }
+
+  float result() const {
+    if (count == 0)
+      return std::numeric_limits<float>::quiet_NaN();
+    if constexpr (R == pyramid_reduction::mean)
+      return static_cast<float>(value / static_cast<double>(count));
+    else
+      return static_cast<float>(value);
+  }
+};
+
+size_t level_size(size_t n, size_t level) { return (n + (size_t{1} << level) - 1) >> level; }
+
+irap_header level_header(const irap_header& header, size_t level) {
+  auto result = header;
+  result.ncol = static_cast<int>(level_size(header.ncol, level));
+  result.nrow = static_cast<int>(level_size(header.nrow, level));
+  const auto factor = static_cast<double>(size_t{1} << level);
+  result.xinc = header.xinc * factor;
+  result.yinc = header.yinc * factor;
+  result.xmax = result.xori + (result.ncol - 1) * result.xinc;
+  result.ymax = result.yori + (result.nrow - 1) * result.yinc;
+  return result;
+}
+
+template <pyramid_reduction R> class pyramid_builder {
+public:
+  pyramid_builder(const irap_header& header, size_t levels)
+      : header(header), levels(levels), tile_levels(std::min(levels, TILE_LEVELS)) {
+    if (levels == 0 || levels > MAX_PYRAMID_LEVELS)
+      throw std::domain_error(
+          std::format("Number of pyramid levels must be between 1 and {}", MAX_PYRAMID_LEVELS)
+      );
+    for (size_t l = 1; l <= levels; ++l) {
+      auto head = level_header(header, l);
+      auto nvalues = size_t(head.ncol) * size_t(head.nrow);
+      result.push_back({.header = head, .values = std::vector<float>(nvalues)});
+    }
+    tile_cols = level_size(header.ncol, tile_levels);
+    tile_rows = level_size(header.nrow, tile_levels);
+    tiles.resize(tile_cols * tile_rows);
+  }
+
+  // Reduce the tiles in nrows rows of tiles starting at first_row, reading input
+  // values with get(col, row). The tiles are split over the hardware threads.
+  template <typename Get> void reduce_tiles(Get&& get, size_t first_row, size_t nrows) {
+    parallel::parallel_for(
+        nrows * tile_cols,
+        [&](size_t first, size_t last) {
+          auto s = make_scratch();
+          for (auto t = first; t < last; ++t)
+            reduce_tile(t / nrows, first_row + t % nrows, get, s);
+        },
+        std::max(size_t{1}, MIN_CELLS_PER_THREAD / (tile_size() * tile_size()))
+    );
+  }
+
+  // Reduce all tiles
+  template <typename Get> void reduce_tiles(Get&& get) { reduce_tiles(get, 0, tile_rows); }
+
+  std::vector<irap> finish() && {
+    auto grid = std::move(tiles);
+    size_t grid_rows = tile_rows;
+    size_t grid_cols = tile_cols;
+    for (size_t l = tile_levels + 1; l <= levels; ++l) {
+      auto& out = result[l - 1];
+      const size_t ncol = out.header.ncol;
+      const size_t nrow = out.header.nrow;
+      auto next = std::vector<accumulator<R>>(ncol * nrow);
+      for (size_t col = 0; col < ncol; ++col)
+        for (size_t row = 0; row < nrow; ++row) {
+          auto& cell = next[col * nrow + row];
+          for (size_t dc = 0; dc < 2; ++dc)
+            for (size_t dr = 0; dr < 2; ++dr)
+              if (2 * col + dc < grid_cols && 2 * row + dr < grid_rows)
+                cell.merge(grid[(2 * col + dc) * grid_rows + 2 * row + dr]);
+          out.values[col * nrow + row] = cell.result();
+        }
+      grid = std::move(next);
+      grid_cols = ncol;
+      grid_rows = nrow;
+    }
+    return std::move(result);
+  }
+
+private:
+  using scratch = std::vector<std::vector<accumulator<R>>>;
+
+  // Number of input rows and columns in one tile
+  size_t tile_size() const { return size_t{1} << tile_levels; }
+
+  scratch make_scratch() const {
+    scratch s;
+    for (size_t l = 1; l <= tile_levels; ++l)
+      s.emplace_back(size_t{1} << 2 * (tile_levels - l));
+    return s;
+  }
+
+  // Compute all tiled levels for one tile, reading input values with get(col, row)
+  template <typename Get> void reduce_tile(size_t tc, size_t tr, Get&& get, scratch& s) {
+    for (size_t l = 1; l <= tile_levels; ++l) {
+      const size_t w = size_t{1} << (tile_levels - l);
+      auto& out = result[l - 1];
+      const size_t ncol = out.header.ncol;
+      const size_t nrow = out.header.nrow;
+      for (size_t a = 0; a < w; ++a) {
+        for (size_t b = 0; b < w; ++b) {
+          const size_t col = tc * w + a;
+          const size_t row = tr * w + b;
+          accumulator<R> cell;
+          if (col < ncol && row < nrow) {
+            for (size_t dc = 0; dc < 2; ++dc)
+              for (size_t dr = 0; dr < 2; ++dr)
+                if (l > 1)
+                  cell.merge(s[l - 2][(2 * a + dc) * 2 * w + 2 * b + dr]);
+                else if (2 * col + dc < size_t(header.ncol) && 2 * row + dr < size_t(header.nrow))
+                  cell.add(get(2 * col + dc, 2 * row + dr));
+            out.values[col * nrow + row] = cell.result();
+          }
+          s[l - 1][a * w + b] = cell;
+        }
+      }
+    }
+    tiles[tc * tile_rows + tr] = s[tile_levels - 1][0];
+  }
+
+  irap_header header;
+  size_t levels;
+  size_t tile_levels;
+  size_t tile_cols;
+  size_t tile_rows;
+  std::vector<irap> result;
+  // results of the coarsest tiled level
+  std::vector<accumulator<R>> tiles;
+};
+
+template <pyramid_reduction R>
+std::vector<irap> build_pyramid(const irap_header& header, surf_span values, size_t levels) {
+  if (values.extent(0) != size_t(header.ncol) || values.extent(1) != size_t(header.nrow))
+    throw std::domain_error("Dimensions of values do not match ncol and nrow of header");
+
+  auto builder = pyramid_builder<R>(header, levels);
+  auto get = [&](size_t col, size_t row) {
+#if __cpp_multidimensional_subscript
+    return values[col, row];
+#else
+    return values(col, row);
+#endif
+  };
+  builder.reduce_tiles(get);
+  return std::move(builder).finish();
+}
+
+template <pyramid_reduction R, typename ReadBlocks>
+std::vector<irap> build_pyramid(
+    ReadBlocks&& read_blocks, const fs::path& file, size_t levels, const io_options& options
+) {
+  std::optional<pyramid_builder<R>> builder;
+  size_t ncol = 0;
+  // Each block holds whole rows of tiles, so the tiles of a block can be reduced in
+  // parallel while the full resolution surface is never stored.
+  const size_t tile_size = size_t{1} << std::min(levels, TILE_LEVELS);
+  const size_t block_rows = std::max(MIN_BLOCK_ROWS, tile_size) / tile_size * tile_size;
+  read_blocks(
+      file, block_rows,
+      [&](const irap_header& header) {
+        builder.emplace(header, levels);
+        ncol = header.ncol;
+      },
+      [&](size_t offset, std::span<const float> block) {
+        const size_t first_row = offset / ncol;
+        const size_t first_tile_row = first_row / tile_size;
+        const size_t tile_rows = (block.size() / ncol + tile_size - 1) / tile_size;
+        auto get = [&](size_t col, size_t row) { return block[(row - first_row) * ncol + col]; };
+        builder->reduce_tiles(get, first_tile_row, tile_rows);
+      },
+      options
+  );
+  return std::move(*builder).finish();
+}
+
+std::vector<irap> make_pyramid(
+    const irap_header& header, surf_span values, size_t levels, pyramid_reduction reduction
+) {
+  switch (reduction) {
+  case pyramid_reduction::min:
+    return build_pyramid<pyramid_reduction::min>(header, values, levels);
+  case pyramid_reduction::max:
+    return build_pyramid<pyramid_reduction::max>(header, values, levels);
+  default:
+    return build_pyramid<pyramid_reduction::mean>(header, values, levels);
+  }
+}
+
+std::vector<irap> make_pyramid(const irap& data, size_t levels, pyramid_reduction reduction) {
+  return make_pyramid(
+      data.header, surf_span{data.values.data(), data.header.ncol, data.header.nrow}, levels,
+      reduction
+  );
+}
+
+template <typename ReadBlocks>
+std::vector<irap> pyramid_from_file(
+    ReadBlocks&& read_blocks, const fs::path& file, size_t levels, pyramid_reduction reduction,
+    const io_options& options
+) {
+  switch (reduction) {
+  case pyramid_reduction::min:
+    return build_pyramid<pyramid_reduction::min>(read_blocks, file, levels, options);
+  case pyramid_reduction::max:
+    return build_pyramid<pyramid_reduction::max>(read_blocks, file, levels, options);
+  default:
+    return build_pyramid<pyramid_reduction::mean>(read_blocks, file, levels, options);
+  }
+}
+
+std::vector<irap> pyramid_from_ascii_file(
+    const fs::path& file, size_t levels, pyramid_reduction reduction, const io_options& options
+) {
+  return pyramid_from_file(read_ascii_file_blocks, file, levels, reduction, options);
+}
+
+std::vector<irap> pyramid_from_binary_file(
+    const fs::path& file, size_t levels, pyramid_reduction reduction, const io_options& options
+) {
+  return pyramid_from_file(read_binary_file_blocks, file, levels, reduction, options);
+}
+} // namespace surfio::irap
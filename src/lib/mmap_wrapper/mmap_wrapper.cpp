@@ -1,27 +1,237 @@
 #include "mmap_wrapper.h"
 #include "mio.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <format>
+#include <fstream>
+#include <new>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SURFIO_POSIX_IO 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define SURFIO_POSIX_IO 0
+#endif
 
 namespace fs = std::filesystem;
 
 namespace surfio::mmap {
+using irap::io_backend;
+
+// Alignment of read buffers, which O_DIRECT requires of buffers, offsets and sizes
+constexpr size_t ALIGNMENT = 4096;
+// Number of bytes requested by each read
+constexpr size_t READ_SIZE = size_t{8} << 20;
+
+struct aligned_delete {
+  void operator()(char* ptr) const { ::operator delete[](ptr, std::align_val_t{ALIGNMENT}); }
+};
+using aligned_buffer = std::unique_ptr<char[], aligned_delete>;
+
+aligned_buffer make_aligned_buffer(size_t size) {
+  return aligned_buffer(
+      static_cast<char*>(::operator new[](std::max(size, size_t{1}), std::align_val_t{ALIGNMENT}))
+  );
+}
+
 struct internals {
-  mio::mmap_source handle;
+  // the file contents are either mapped or read into buffer
+  mio::mmap_source mapping;
+  aligned_buffer buffer;
+  size_t size = 0;
 };
 
-mmap_file::mmap_file(const fs::path& file) {
+std::string environment_variable(const char* name) {
+#ifdef _WIN32
+  char* value = nullptr;
+  size_t length = 0;
+  if (_dupenv_s(&value, &length, name) || !value)
+    return {};
+  std::string result(value);
+  free(value);
+  return result;
+#else
+  auto value = std::getenv(name);
+  return value ? value : "";
+#endif
+}
+
+io_backend resolve_backend(io_backend backend) {
+  if (backend != io_backend::automatic)
+    return backend;
+
+  auto value = environment_variable("SURFIO_IO_BACKEND");
+  if (value.empty() || value == "mmap")
+    return io_backend::mmap;
+  if (value == "pread")
+    return io_backend::pread;
+  if (value == "direct")
+    return io_backend::direct;
+  throw std::domain_error(
+      std::format("Unknown SURFIO_IO_BACKEND: {}. Expected mmap, pread or direct", value)
+  );
+}
+
+[[noreturn]] void throw_read_error(const fs::path& file, const std::string& message) {
+  throw std::runtime_error(
+      std::format("failed to read file :{}, with error: {}", file.string(), message)
+  );
+}
+
+void map_file(internals& d, const fs::path& file, const irap::io_options& options) {
   std::error_code ec;
-  auto handle = mio::make_mmap_source(file.string(), ec);
+  d.mapping = mio::make_mmap_source(file.string(), ec);
   if (ec)
     throw std::runtime_error(
         std::format("failed to map file :{}, with error: {}", file.string(), ec.message())
     );
+  d.size = d.mapping.size();
+
+#if SURFIO_POSIX_IO
+  // these are only hints, so failures are ignored
+  auto addr = const_cast<char*>(d.mapping.data());
+  madvise(addr, d.size, MADV_SEQUENTIAL);
+  if (options.populate) {
+#ifdef MADV_POPULATE_READ
+    if (madvise(addr, d.size, MADV_POPULATE_READ) != 0)
+#endif
+      madvise(addr, d.size, MADV_WILLNEED);
+  }
+#ifdef MADV_HUGEPAGE
+  if (options.huge_pages)
+    madvise(addr, d.size, MADV_HUGEPAGE);
+#endif
+#else
+  (void)options;
+#endif
+}
+
+#if SURFIO_POSIX_IO
+struct file_descriptor {
+  int fd;
+  ~file_descriptor() {
+    if (fd >= 0)
+      close(fd);
+  }
+};
+
+size_t file_size(const file_descriptor& f, const fs::path& file) {
+  struct stat st;
+  if (fstat(f.fd, &st) != 0)
+    throw_read_error(file, std::system_category().message(errno));
+  return static_cast<size_t>(st.st_size);
+}
+
+// Read until end of file or until capacity bytes are read, and return the number of
+// bytes read. Returns nullopt if a read fails with EINVAL, which is how O_DIRECT reads
+// fail on filesystems that do not support them. With direct, reading stops at a read
+// that does not end on the alignment, which O_DIRECT only returns at end of file, as
+// some filesystems reject the unaligned read that would follow with EINVAL.
+std::optional<size_t> read_file_descriptor(
+    const file_descriptor& f, char* buffer, size_t capacity, const fs::path& file,
+    bool direct = false
+) {
+  size_t offset = 0;
+  while (offset < capacity) {
+    auto n = pread(
+        f.fd, buffer + offset, std::min(READ_SIZE, capacity - offset), static_cast<off_t>(offset)
+    );
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EINVAL)
+        return std::nullopt;
+      throw_read_error(file, std::system_category().message(errno));
+    }
+    if (n == 0)
+      break;
+    offset += static_cast<size_t>(n);
+    if (direct && offset % ALIGNMENT != 0)
+      break;
+  }
+  return offset;
+}
+
+void read_buffered(internals& d, const fs::path& file) {
+  auto f = file_descriptor{open(file.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (f.fd < 0)
+    throw_read_error(file, std::system_category().message(errno));
+#ifdef POSIX_FADV_SEQUENTIAL
+  // doubles the read-ahead window on Linux
+  posix_fadvise(f.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  auto size = file_size(f, file);
+  d.buffer = make_aligned_buffer(size);
+  auto read = read_file_descriptor(f, d.buffer.get(), size, file);
+  if (!read)
+    throw_read_error(file, std::system_category().message(EINVAL));
+  d.size = *read;
+}
+
+void read_direct(internals& d, const fs::path& file) {
+#ifdef O_DIRECT
+  auto f = file_descriptor{open(file.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT)};
+  if (f.fd < 0 && errno == EINVAL)
+    return read_buffered(d, file);
+#else
+  auto f = file_descriptor{open(file.c_str(), O_RDONLY | O_CLOEXEC)};
+#ifdef F_NOCACHE
+  if (f.fd >= 0)
+    fcntl(f.fd, F_NOCACHE, 1);
+#endif
+#endif
+  if (f.fd < 0)
+    throw_read_error(file, std::system_category().message(errno));
+
+  // O_DIRECT reads whole blocks, so the buffer is rounded up to the alignment
+  auto size = file_size(f, file);
+  auto capacity = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  d.buffer = make_aligned_buffer(capacity);
+  auto read = read_file_descriptor(f, d.buffer.get(), capacity, file, true);
+  if (!read)
+    return read_buffered(d, file);
+  d.size = std::min(*read, size);
+}
+#else
+void read_buffered(internals& d, const fs::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  std::error_code ec;
+  auto size = fs::file_size(file, ec);
+  if (!in || ec)
+    throw_read_error(file, ec ? ec.message() : "could not open file");
+  d.buffer = make_aligned_buffer(size);
+  in.read(d.buffer.get(), static_cast<std::streamsize>(size));
+  d.size = static_cast<size_t>(in.gcount());
+}
 
-  d = std::make_unique<internals>(std::move(handle));
+void read_direct(internals& d, const fs::path& file) { read_buffered(d, file); }
+#endif
+
+input_file::input_file(const fs::path& file, const irap::io_options& options)
+    : d(std::make_unique<internals>()) {
+  switch (resolve_backend(options.backend)) {
+  case io_backend::pread:
+    read_buffered(*d, file);
+    break;
+  case io_backend::direct:
+    read_direct(*d, file);
+    break;
+  default:
+    map_file(*d, file, options);
+  }
 }
 
-mmap_file::~mmap_file() {}
-const char* mmap_file::begin() const { return d->handle.begin(); }
-const char* mmap_file::end() const { return d->handle.end(); }
+input_file::~input_file() {}
+const char* input_file::begin() const {
+  return d->buffer ? d->buffer.get() : d->mapping.data();
+}
+const char* input_file::end() const { return begin() + d->size; }
 } // namespace surfio::mmap
@@ -1,13 +1,17 @@
+#pragma once
+
+#include "../include/io_options.h"
 #include <filesystem>
 #include <memory>
 
 namespace surfio::mmap {
 struct internals;
 
-class mmap_file {
+// The contents of a file, read into memory by one of the backends in io_backend
+class input_file {
 public:
-  mmap_file(const std::filesystem::path& file);
-  ~mmap_file();
+  input_file(const std::filesystem::path& file, const irap::io_options& options = {});
+  ~input_file();
   const char* begin() const;
   const char* end() const;
 
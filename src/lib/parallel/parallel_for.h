@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace surfio::parallel {
+inline size_t thread_count() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+// Inputs that are scanned in parallel, as in validation, are only split into segments
+// of at least this many bytes, as smaller segments cost more to start than they save
+constexpr size_t MIN_SEGMENT_BYTES = size_t{1} << 20;
+
+// Number of parts to split n items into, one per thread but with at least
+// min_per_part items in each part
+inline size_t part_count(size_t n, size_t min_per_part) {
+  return std::clamp(n / min_per_part, size_t{1}, thread_count());
+}
+
+// Split [0, n) into one contiguous range per thread and call f(begin, end) for each
+// of them. The calling thread takes the first range. An exception thrown by f is
+// rethrown in the calling thread once all ranges are done.
+template <typename F> void parallel_for(size_t n, F&& f, size_t min_per_thread = 1) {
+  auto nthreads = std::min(thread_count(), (n + min_per_thread - 1) / min_per_thread);
+  if (nthreads <= 1) {
+    if (n > 0)
+      f(size_t{0}, n);
+    return;
+  }
+
+  auto range_begin = [&](size_t t) { return n * t / nthreads; };
+  std::vector<std::exception_ptr> errors(nthreads);
+  auto run = [&](size_t t) {
+    try {
+      f(range_begin(t), range_begin(t + 1));
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(nthreads - 1);
+    for (size_t t = 1; t < nthreads; ++t)
+      threads.emplace_back(run, t);
+    run(0);
+  }
+
+  for (auto& error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+} // namespace surfio::parallel
@@ -1,10 +1,20 @@
 #pragma once
 
 #include "irap.h"
+#include <mutex>
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <utility>
 
+// On free-threaded Python, a thread may assign new values to a surface while another
+// takes a reference to them, so header and values are only read and replaced under
+// mutex. Nothing that can call into Python runs under it, as that could wait for a
+// thread that waits for the mutex.
 struct irap_python {
+  irap_python(surfio::irap::irap_header header, pybind11::array_t<float> values)
+      : header(header), values(std::move(values)) {}
+
   surfio::irap::irap_header header;
   pybind11::array_t<float> values;
+  mutable std::mutex mutex;
 };
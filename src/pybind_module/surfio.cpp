@@ -1,13 +1,27 @@
 #include "include/irap_pybind.h"
+#include "io_options.h"
 #include "irap_export.h"
+#include "irap_expression.h"
 #include "irap_import.h"
+#include "irap_pyramid.h"
+#include "irap_validate.h"
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <format>
+#include <limits>
+#include <mutex>
+#include <optional>
 #include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include <pybind11/stl/filesystem.h>
+#include <span>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace py = pybind11;
 namespace fs = std::filesystem;
@@ -15,14 +29,21 @@ using namespace surfio;
 
 irap_python* make_irap_python(const irap::irap& data) {
   constexpr auto size = sizeof(decltype(irap::irap::values)::value_type);
-  return new irap_python{
+  return new irap_python(
       data.header,
       {{data.header.ncol, data.header.nrow}, {size * data.header.nrow, size}, data.values.data()}
-  };
+  );
+}
+
+py::list make_irap_python_list(const std::vector<irap::irap>& data) {
+  py::list result;
+  for (auto& irap : data)
+    result.append(py::cast(make_irap_python(irap), py::return_value_policy::take_ownership));
+  return result;
 }
 
-irap::surf_span make_surf_span(const irap_python& ip) {
-  return irap::surf_span{ip.values.data(), ip.values.shape(0), ip.values.shape(1)};
+irap::surf_span make_surf_span(const py::array_t<float>& values) {
+  return irap::surf_span{values.data(), values.shape(0), values.shape(1)};
 }
 
 surfio::irap::irap_header fill_header(const surfio::irap::irap_header& head) {
@@ -32,7 +53,264 @@ surfio::irap::irap_header fill_header(const surfio::irap::irap_header& head) {
 
   return header;
 }
-PYBIND11_MODULE(_surfio, m) {
+
+// The header and values of a surface, copied under its lock. values is a new
+// reference, so the array stays alive if another thread assigns new values.
+struct surface_state {
+  irap::irap_header header;
+  py::array_t<float> values;
+};
+
+surface_state lock_surface(const irap_python& ip) {
+  std::lock_guard lock(ip.mutex);
+  return {ip.header, ip.values};
+}
+
+// values may have been assigned an array of any layout, which is converted to C order
+// float32 here if it is not already
+py::array_t<float> c_order_values(const py::array_t<float>& values) {
+  auto result = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(values);
+  if (!result || result.ndim() != 2)
+    throw std::domain_error("Dimensions of values do not match ncol and nrow of header");
+  return py::array_t<float>(result);
+}
+
+// A surface prepared for use while the GIL is released. values holds a reference to
+// the array that span points into.
+struct surface_view {
+  py::array_t<float> values;
+  irap::irap_header header;
+  irap::surf_span span;
+};
+
+surface_view view_surface(const irap_python& ip) {
+  auto [header, held] = lock_surface(ip);
+  auto values = c_order_values(held);
+  auto span = make_surf_span(values);
+  return {std::move(values), fill_header(header), span};
+}
+
+// Raw bytes of a buffer protocol object. The view is owned by info, which keeps
+// the memory alive (and e.g. a bytearray from being resized) while it exists.
+std::span<const char> buffer_bytes(const py::buffer_info& info) {
+  if (!PyBuffer_IsContiguous(info.view(), 'C'))
+    throw py::buffer_error("Irap import requires a C-contiguous buffer");
+  return {static_cast<const char*>(info.ptr), static_cast<size_t>(info.size * info.itemsize)};
+}
+
+// Layout of the start of a shared memory segment holding an IrapSurface, which is
+// followed by the values at SHARED_MEMORY_VALUES_OFFSET
+struct shared_memory_header {
+  int32_t id = irap::irap_header::id;
+  int32_t ncol;
+  int32_t nrow;
+  int32_t reserved = 0;
+  double xori, yori, xmax, ymax, xinc, yinc, rot, xrot, yrot;
+};
+constexpr size_t SHARED_MEMORY_VALUES_OFFSET = 128;
+static_assert(sizeof(shared_memory_header) <= SHARED_MEMORY_VALUES_OFFSET);
+
+py::object create_shared_memory(size_t size, const std::optional<std::string>& name) {
+  auto shared_memory = py::module_::import("multiprocessing.shared_memory").attr("SharedMemory");
+  return shared_memory(py::arg("name") = name, py::arg("create") = true, py::arg("size") = size);
+}
+
+py::object attach_shared_memory(const std::string& name) {
+  auto shared_memory = py::module_::import("multiprocessing.shared_memory").attr("SharedMemory");
+#if PY_VERSION_HEX >= 0x030D0000
+  // otherwise the resource tracker of the attaching process unlinks the segment when
+  // that process exits
+  return shared_memory(py::arg("name") = name, py::arg("track") = false);
+#else
+  return shared_memory(py::arg("name") = name);
+#endif
+}
+
+irap_python* surface_from_shared_memory(py::object shm) {
+  py::object buf = shm.attr("buf");
+  shared_memory_header head;
+  {
+    auto info = buf.cast<py::buffer>().request();
+    auto bytes = buffer_bytes(info);
+    if (bytes.size() < SHARED_MEMORY_VALUES_OFFSET)
+      throw std::domain_error("Shared memory is too small to hold an IrapSurface");
+    std::memcpy(&head, bytes.data(), sizeof(head));
+    if (head.id != irap::irap_header::id || head.ncol < 0 || head.nrow < 0)
+      throw std::domain_error("Shared memory does not hold an IrapSurface");
+    auto nvalues = size_t(head.ncol) * size_t(head.nrow);
+    if ((bytes.size() - SHARED_MEMORY_VALUES_OFFSET) / sizeof(float) < nvalues)
+      throw std::domain_error("Shared memory is too small for ncol and nrow of the IrapSurface");
+  }
+
+  // flat holds an export of the buffer for as long as the values exist. It comes last in
+  // the base, so it is released before the segment is closed when the values are deleted.
+  auto flat = py::array_t<float>(py::module_::import("numpy").attr("frombuffer")(
+      buf, py::dtype::of<float>(), py::arg("count") = size_t(head.ncol) * size_t(head.nrow),
+      py::arg("offset") = SHARED_MEMORY_VALUES_OFFSET
+  ));
+  constexpr auto size = sizeof(float);
+  auto header = irap::irap_header{
+      .ncol = head.ncol,
+      .nrow = head.nrow,
+      .xori = head.xori,
+      .yori = head.yori,
+      .xmax = head.xmax,
+      .ymax = head.ymax,
+      .xinc = head.xinc,
+      .yinc = head.yinc,
+      .rot = head.rot,
+      .xrot = head.xrot,
+      .yrot = head.yrot,
+  };
+  return new irap_python(
+      header,
+      py::array_t<float>(
+          {head.ncol, head.nrow}, {size * head.nrow, size}, flat.data(), py::make_tuple(shm, flat)
+      )
+  );
+}
+
+// An expression together with the values of the surfaces in it, which it reads from
+// and which must live as long as it does
+struct surface_expression {
+  irap::expression expression;
+  std::vector<py::array_t<float>> arrays;
+};
+
+std::optional<surface_expression> as_expression(py::handle operand) {
+  if (py::isinstance<surface_expression>(operand))
+    return operand.cast<surface_expression>();
+  if (py::isinstance<irap_python>(operand)) {
+    auto [header, held] = lock_surface(operand.cast<const irap_python&>());
+    auto values = c_order_values(held);
+    return surface_expression{irap::expression(header, make_surf_span(values)), {values}};
+  }
+  if (!py::isinstance<py::array>(operand) && py::hasattr(operand, "__float__"))
+    return surface_expression{irap::expression(operand.cast<float>()), {}};
+  return std::nullopt;
+}
+
+surface_expression to_expression(py::handle operand) {
+  if (auto result = as_expression(operand))
+    return *std::move(result);
+  throw py::type_error("Operands must be IrapSurface, SurfaceExpression or numbers");
+}
+
+// None stands for a missing bound, which is NaN in irap::clip
+surface_expression to_bound(py::handle bound) {
+  return bound.is_none() ? surface_expression{std::numeric_limits<float>::quiet_NaN(), {}}
+                         : to_expression(bound);
+}
+
+template <typename Op, typename... Operands>
+surface_expression apply(Op op, const Operands&... operands) {
+  auto result = surface_expression{op(operands.expression...), {}};
+  // each array is held once, however often its surface appears in the expression
+  auto add_arrays = [&](const surface_expression& operand) {
+    for (const auto& array : operand.arrays)
+      if (std::ranges::none_of(result.arrays, [&](const auto& held) { return held.is(array); }))
+        result.arrays.push_back(array);
+  };
+  (add_arrays(operands), ...);
+  return result;
+}
+
+// Add the arithmetic, comparison and logical operators, which build expressions, to a
+// class of operands. Equality is left alone, so surfaces still compare as objects.
+template <typename T> void def_expression_operators(py::class_<T>& cls) {
+  // numpy would otherwise apply its operators to each element of an array with the
+  // operand, instead of leaving them to the reflected operators of the class
+  cls.attr("__array_ufunc__") = py::none();
+  auto binary = [&](const char* name, auto op, bool reflected = false) {
+    cls.def(name, [op, reflected](py::object self, py::object other) -> py::object {
+      auto lhs = to_expression(self);
+      auto rhs = as_expression(other);
+      if (!rhs)
+        return py::reinterpret_borrow<py::object>(Py_NotImplemented);
+      return py::cast(reflected ? apply(op, *rhs, lhs) : apply(op, lhs, *rhs));
+    });
+  };
+  auto unary = [&](const char* name, auto op) {
+    cls.def(name, [op](py::object self) {
+      auto operand = to_expression(self);
+      return apply(op, operand);
+    });
+  };
+  using E = const irap::expression&;
+  auto add = [](E a, E b) { return a + b; };
+  auto subtract = [](E a, E b) { return a - b; };
+  auto multiply = [](E a, E b) { return a * b; };
+  auto divide = [](E a, E b) { return a / b; };
+  auto logical_and = [](E a, E b) { return irap::logical_and(a, b); };
+  auto logical_or = [](E a, E b) { return irap::logical_or(a, b); };
+  binary("__add__", add);
+  binary("__radd__", add, true);
+  binary("__sub__", subtract);
+  binary("__rsub__", subtract, true);
+  binary("__mul__", multiply);
+  binary("__rmul__", multiply, true);
+  binary("__truediv__", divide);
+  binary("__rtruediv__", divide, true);
+  binary("__and__", logical_and);
+  binary("__rand__", logical_and, true);
+  binary("__or__", logical_or);
+  binary("__ror__", logical_or, true);
+  binary("__lt__", [](E a, E b) { return a < b; });
+  binary("__le__", [](E a, E b) { return a <= b; });
+  binary("__gt__", [](E a, E b) { return a > b; });
+  binary("__ge__", [](E a, E b) { return a >= b; });
+  unary("__neg__", [](E a) { return -a; });
+  unary("__abs__", [](E a) { return irap::abs(a); });
+  unary("__invert__", [](E a) { return irap::logical_not(a); });
+  cls.def(
+      "clip",
+      [](py::object self, py::object lower, py::object upper) {
+        auto value = to_expression(self);
+        auto low = to_bound(lower);
+        auto high = to_bound(upper);
+        return apply([](E v, E l, E u) { return irap::clip(v, l, u); }, value, low, high);
+      },
+      py::arg("lower") = py::none(), py::arg("upper") = py::none()
+  );
+}
+
+// The module keeps no mutable state of its own. The header and values of an IrapSurface
+// are only read and assigned under its lock, and every call that releases the GIL first
+// takes its own references to the Python objects it reads from, so it can run without
+// the GIL on free-threaded Python. As with numpy arrays, concurrent changes to the
+// elements of the values are left to the caller to synchronize.
+PYBIND11_MODULE(_surfio, m, py::mod_gil_not_used()) {
+  py::enum_<irap::pyramid_reduction>(m, "PyramidReduction")
+      .value("mean", irap::pyramid_reduction::mean)
+      .value("min", irap::pyramid_reduction::min)
+      .value("max", irap::pyramid_reduction::max);
+
+  py::enum_<irap::io_backend>(m, "IoBackend")
+      .value("automatic", irap::io_backend::automatic)
+      .value("mmap", irap::io_backend::mmap)
+      .value("pread", irap::io_backend::pread)
+      .value("direct", irap::io_backend::direct);
+
+  py::class_<irap::io_options>(m, "IoOptions")
+      .def(
+          py::init<irap::io_backend, bool, bool>(), py::kw_only(),
+          py::arg("backend") = irap::io_backend::automatic, py::arg("populate") = false,
+          py::arg("huge_pages") = false
+      )
+      .def(
+          "__repr__",
+          [](const irap::io_options& options) {
+            return std::format(
+                "<IoOptions(backend={}, populate={}, huge_pages={})>",
+                py::repr(py::cast(options.backend)).cast<std::string>(),
+                options.populate ? "True" : "False", options.huge_pages ? "True" : "False"
+            );
+          }
+      )
+      .def_readwrite("backend", &irap::io_options::backend)
+      .def_readwrite("populate", &irap::io_options::populate)
+      .def_readwrite("huge_pages", &irap::io_options::huge_pages);
+
   py::class_<irap::irap_header>(m, "IrapHeader")
       .def(
           py::init<
@@ -54,6 +332,31 @@ PYBIND11_MODULE(_surfio, m) {
       )
       .def(py::self == py::self)
       .def(py::self != py::self)
+      .def(py::pickle(
+          [](const irap::irap_header& header) {
+            return py::make_tuple(
+                header.ncol, header.nrow, header.xori, header.yori, header.xmax, header.ymax,
+                header.xinc, header.yinc, header.rot, header.xrot, header.yrot
+            );
+          },
+          [](const py::tuple& state) {
+            if (state.size() != 11)
+              throw std::domain_error("Invalid state for IrapHeader");
+            return irap::irap_header{
+                .ncol = state[0].cast<int>(),
+                .nrow = state[1].cast<int>(),
+                .xori = state[2].cast<double>(),
+                .yori = state[3].cast<double>(),
+                .xmax = state[4].cast<double>(),
+                .ymax = state[5].cast<double>(),
+                .xinc = state[6].cast<double>(),
+                .yinc = state[7].cast<double>(),
+                .rot = state[8].cast<double>(),
+                .xrot = state[9].cast<double>(),
+                .yrot = state[10].cast<double>(),
+            };
+          }
+      ))
       .def_readonly_static("id", &irap::irap_header::id)
       .def_readwrite("ncol", &irap::irap_header::ncol)
       .def_readwrite("nrow", &irap::irap_header::nrow)
@@ -67,7 +370,8 @@ PYBIND11_MODULE(_surfio, m) {
       .def_readwrite("xrot", &irap::irap_header::xrot)
       .def_readwrite("yrot", &irap::irap_header::yrot);
 
-  py::class_<irap_python>(m, "IrapSurface")
+  py::class_<irap_python> surface_class(m, "IrapSurface");
+  surface_class
       .def(
           py::init<
               irap::irap_header, py::array_t<float, py::array::c_style | py::array::forcecast>>(),
@@ -76,27 +380,119 @@ PYBIND11_MODULE(_surfio, m) {
       .def(
           "__repr__",
           [](const irap_python& ip) {
+            auto h = lock_surface(ip).header;
             return std::format(
                 "<IrapSurface(header=IrapHeader(ncol={}, nrow={}, xori={}, yori={}, xmax={}, "
                 "ymax={}, xinc={}, yinc={}, rot={}, xrot={}, yrot={}), values=...)>",
-                ip.header.ncol, ip.header.nrow, ip.header.xori, ip.header.yori, ip.header.xmax,
-                ip.header.ymax, ip.header.xinc, ip.header.yinc, ip.header.rot, ip.header.xrot,
-                ip.header.yrot
+                h.ncol, h.nrow, h.xori, h.yori, h.xmax, h.ymax, h.xinc, h.yinc, h.rot, h.xrot,
+                h.yrot
             );
           }
       )
-      .def_readwrite("header", &irap_python::header)
-      .def_readwrite("values", &irap_python::values)
+      // a copy, as a reference into the surface could be changed without its lock
+      .def_property(
+          "header", [](const irap_python& ip) { return lock_surface(ip).header; },
+          [](irap_python& ip, const irap::irap_header& header) {
+            std::lock_guard lock(ip.mutex);
+            ip.header = header;
+          }
+      )
+      .def_property(
+          "values", [](const irap_python& ip) { return lock_surface(ip).values; },
+          [](irap_python& ip, py::array_t<float> values) {
+            {
+              std::lock_guard lock(ip.mutex);
+              std::swap(ip.values, values);
+            }
+            // the previous values are released after the lock, as that can call into Python
+          }
+      )
+      .def(py::pickle(
+          // The values are pickled by numpy, which with protocol 5 passes them as an
+          // out-of-band buffer when the pickler has a buffer_callback
+          [](const irap_python& ip) {
+            auto [header, values] = lock_surface(ip);
+            return py::make_tuple(header, values);
+          },
+          [](const py::tuple& state) {
+            if (state.size() != 2)
+              throw std::domain_error("Invalid state for IrapSurface");
+            return new irap_python(
+                state[0].cast<irap::irap_header>(),
+                state[1].cast<py::array_t<float, py::array::c_style | py::array::forcecast>>()
+            );
+          }
+      ))
+      .def(
+          "to_shared_memory",
+          [](const irap_python& ip, const std::optional<std::string>& name) -> py::object {
+            auto [h, held] = lock_surface(ip);
+            auto values = c_order_values(held);
+            if (values.shape(0) != h.ncol || values.shape(1) != h.nrow)
+              throw std::domain_error("Dimensions of values do not match ncol and nrow of header");
+            auto head = shared_memory_header{
+                .ncol = h.ncol,
+                .nrow = h.nrow,
+                .xori = h.xori,
+                .yori = h.yori,
+                .xmax = h.xmax,
+                .ymax = h.ymax,
+                .xinc = h.xinc,
+                .yinc = h.yinc,
+                .rot = h.rot,
+                .xrot = h.xrot,
+                .yrot = h.yrot,
+            };
+            auto size = static_cast<size_t>(values.size()) * sizeof(float);
+            auto shm = create_shared_memory(SHARED_MEMORY_VALUES_OFFSET + size, name);
+            try {
+              auto info = shm.attr("buf").cast<py::buffer>().request(true);
+              auto data = static_cast<char*>(info.ptr);
+              std::memcpy(data, &head, sizeof(head));
+              py::gil_scoped_release release;
+              std::memcpy(data + SHARED_MEMORY_VALUES_OFFSET, values.data(), size);
+            } catch (...) {
+              // the segment never reaches the caller, who could otherwise unlink it
+              shm.attr("close")();
+              shm.attr("unlink")();
+              throw;
+            }
+            return shm;
+          },
+          py::arg("name") = py::none()
+      )
+      .def_static(
+          "from_shared_memory",
+          [](py::object shm) -> irap_python* {
+            if (py::isinstance<py::str>(shm))
+              shm = attach_shared_memory(shm.cast<std::string>());
+            return surface_from_shared_memory(shm);
+          },
+          py::arg("shm")
+      )
       .def_static(
           "from_ascii_file",
-          [](fs::path file) -> irap_python* {
-            auto irap = irap::from_ascii_file(file);
+          [](fs::path file, const irap::io_options& io_options) -> irap_python* {
+            auto irap = irap::from_ascii_file(file, io_options);
             // lock the GIL before creating the numpy array
             py::gil_scoped_acquire acquire;
             return make_irap_python(irap);
           },
+          py::arg("file"), py::kw_only(), py::arg("io_options") = irap::io_options{},
           py::call_guard<py::gil_scoped_release>()
       )
+      .def_static(
+          "from_ascii_string",
+          [](const py::buffer& buffer) -> irap_python* {
+            auto info = buffer.request();
+            auto bytes = buffer_bytes(info);
+            auto irap = [&] {
+              py::gil_scoped_release release;
+              return irap::from_ascii_string(std::string_view{bytes.data(), bytes.size()});
+            }();
+            return make_irap_python(irap);
+          }
+      )
       .def_static(
           "from_ascii_string",
           [](std::string_view string) -> irap_python* {
@@ -109,44 +505,229 @@ PYBIND11_MODULE(_surfio, m) {
       )
       .def_static(
           "from_binary_file",
-          [](fs::path file) -> irap_python* {
-            auto irap = irap::from_binary_file(file);
+          [](fs::path file, const irap::io_options& io_options) -> irap_python* {
+            auto irap = irap::from_binary_file(file, io_options);
             // lock the GIL before creating the numpy array
             py::gil_scoped_acquire acquire;
             return make_irap_python(irap);
           },
+          py::arg("file"), py::kw_only(), py::arg("io_options") = irap::io_options{},
           py::call_guard<py::gil_scoped_release>()
       )
       .def_static(
           "from_binary_buffer",
-          [](const py::bytes& buffer) -> irap_python* {
-            auto irap = irap::from_binary_buffer(std::string_view{buffer});
-            // lock the GIL before creating the numpy array
-            py::gil_scoped_acquire acquire;
+          [](const py::buffer& buffer) -> irap_python* {
+            auto info = buffer.request();
+            auto bytes = buffer_bytes(info);
+            auto irap = [&] {
+              py::gil_scoped_release release;
+              return irap::from_binary_buffer(bytes);
+            }();
             return make_irap_python(irap);
-          },
-          py::call_guard<py::gil_scoped_release>()
+          }
       )
       .def(
           "to_ascii_string",
           [](const irap_python& ip) -> std::string {
-            return irap::to_ascii_string(fill_header(ip.header), make_surf_span(ip));
+            auto [values, header, span] = view_surface(ip);
+            py::gil_scoped_release release;
+            return irap::to_ascii_string(header, span);
           }
       )
       .def(
           "to_ascii_file",
           [](const irap_python& ip, fs::path file) -> void {
-            irap::to_ascii_file(file, fill_header(ip.header), make_surf_span(ip));
+            auto [values, header, span] = view_surface(ip);
+            py::gil_scoped_release release;
+            irap::to_ascii_file(file, header, span);
           }
       )
       .def(
           "to_binary_buffer",
           [](const irap_python& ip) -> py::bytes {
-            auto buffer = irap::to_binary_buffer(fill_header(ip.header), make_surf_span(ip));
+            auto [values, header, span] = view_surface(ip);
+            auto buffer = [&] {
+              py::gil_scoped_release release;
+              return irap::to_binary_buffer(header, span);
+            }();
             return py::bytes(buffer);
           }
       )
-      .def("to_binary_file", [](const irap_python& ip, fs::path file) -> void {
-        irap::to_binary_file(file, fill_header(ip.header), make_surf_span(ip));
+      .def(
+          "to_binary_file",
+          [](const irap_python& ip, fs::path file) -> void {
+            auto [values, header, span] = view_surface(ip);
+            py::gil_scoped_release release;
+            irap::to_binary_file(file, header, span);
+          }
+      )
+      .def(
+          "make_pyramid",
+          [](const irap_python& ip, size_t levels, irap::pyramid_reduction reduction) -> py::list {
+            auto [values, header, span] = view_surface(ip);
+            auto pyramid = [&] {
+              py::gil_scoped_release release;
+              return irap::make_pyramid(header, span, levels, reduction);
+            }();
+            return make_irap_python_list(pyramid);
+          },
+          py::arg("levels"), py::arg("reduction") = irap::pyramid_reduction::mean
+      )
+      .def_static(
+          "pyramid_from_ascii_file",
+          [](fs::path file, size_t levels, irap::pyramid_reduction reduction,
+             const irap::io_options& io_options) -> py::list {
+            auto pyramid = irap::pyramid_from_ascii_file(file, levels, reduction, io_options);
+            // lock the GIL before creating the numpy arrays
+            py::gil_scoped_acquire acquire;
+            return make_irap_python_list(pyramid);
+          },
+          py::arg("file"), py::arg("levels"), py::arg("reduction") = irap::pyramid_reduction::mean,
+          py::kw_only(), py::arg("io_options") = irap::io_options{},
+          py::call_guard<py::gil_scoped_release>()
+      )
+      .def_static(
+          "pyramid_from_binary_file",
+          [](fs::path file, size_t levels, irap::pyramid_reduction reduction,
+             const irap::io_options& io_options) -> py::list {
+            auto pyramid = irap::pyramid_from_binary_file(file, levels, reduction, io_options);
+            // lock the GIL before creating the numpy arrays
+            py::gil_scoped_acquire acquire;
+            return make_irap_python_list(pyramid);
+          },
+          py::arg("file"), py::arg("levels"), py::arg("reduction") = irap::pyramid_reduction::mean,
+          py::kw_only(), py::arg("io_options") = irap::io_options{},
+          py::call_guard<py::gil_scoped_release>()
+      );
+
+  def_expression_operators(surface_class);
+
+  py::class_<surface_expression> expression_class(m, "SurfaceExpression");
+  expression_class
+      .def(
+          "__repr__",
+          [](const surface_expression& e) {
+            const auto& header = e.expression.header();
+            if (!header)
+              return std::string("<SurfaceExpression()>");
+            return std::format("<SurfaceExpression(ncol={}, nrow={})>", header->ncol, header->nrow);
+          }
+      )
+      .def_property_readonly(
+          "header", [](const surface_expression& e) { return e.expression.header(); }
+      )
+      .def(
+          "__bool__",
+          [](const surface_expression&) -> bool {
+            throw py::type_error(
+                "The truth value of a SurfaceExpression is ambiguous, evaluate it first"
+            );
+          }
+      )
+      .def("evaluate", [](const surface_expression& e) -> irap_python* {
+        const auto& header = e.expression.header();
+        if (!header)
+          throw std::domain_error("Expression contains no surface");
+        // evaluate straight into the numpy array of the result
+        auto values = py::array_t<float>({header->ncol, header->nrow});
+        auto out = std::span<float>(values.mutable_data(), static_cast<size_t>(values.size()));
+        // the arrays of e are kept alive by the caller while the GIL is released
+        auto expression = e.expression;
+        {
+          py::gil_scoped_release release;
+          expression.evaluate(out);
+        }
+        return new irap_python(*header, values);
       });
+  def_expression_operators(expression_class);
+
+  py::class_<irap::validation_report>(m, "ValidationReport")
+      .def(
+          "__repr__",
+          [](const irap::validation_report& report) {
+            return std::format(
+                "<ValidationReport(valid={}, error='{}', first_bad_offset={}, "
+                "value_count={}, undef_count={})>",
+                report.valid ? "True" : "False", report.error,
+                report.first_bad_offset ? std::to_string(*report.first_bad_offset) : "None",
+                report.value_count, report.undef_count
+            );
+          }
+      )
+      .def("__bool__", [](const irap::validation_report& report) { return report.valid; })
+      .def_readonly("valid", &irap::validation_report::valid)
+      .def_readonly("error", &irap::validation_report::error)
+      .def_readonly("first_bad_offset", &irap::validation_report::first_bad_offset)
+      .def_readonly("expected_guard", &irap::validation_report::expected_guard)
+      .def_readonly("actual_guard", &irap::validation_report::actual_guard)
+      .def_readonly("header", &irap::validation_report::header)
+      .def_readonly("expected_values", &irap::validation_report::expected_values)
+      .def_readonly("value_count", &irap::validation_report::value_count)
+      .def_readonly("undef_count", &irap::validation_report::undef_count);
+
+  m.def(
+      "validate_ascii_file", &irap::validate_ascii_file, py::arg("file"), py::kw_only(),
+      py::arg("io_options") = irap::io_options{}, py::call_guard<py::gil_scoped_release>()
+  );
+  m.def(
+      "validate_ascii_string",
+      [](const py::buffer& buffer) {
+        auto info = buffer.request();
+        auto bytes = buffer_bytes(info);
+        py::gil_scoped_release release;
+        return irap::validate_ascii_string(std::string_view{bytes.data(), bytes.size()});
+      },
+      py::arg("buffer")
+  );
+  m.def(
+      "validate_ascii_string", &irap::validate_ascii_string, py::arg("buffer"),
+      py::call_guard<py::gil_scoped_release>()
+  );
+  m.def(
+      "validate_binary_file", &irap::validate_binary_file, py::arg("file"), py::kw_only(),
+      py::arg("io_options") = irap::io_options{}, py::call_guard<py::gil_scoped_release>()
+  );
+  m.def(
+      "validate_binary_buffer",
+      [](const py::buffer& buffer) {
+        auto info = buffer.request();
+        auto bytes = buffer_bytes(info);
+        py::gil_scoped_release release;
+        return irap::validate_binary_buffer(bytes);
+      },
+      py::arg("buffer")
+  );
+
+  m.def(
+      "fmin",
+      [](py::object a, py::object b) {
+        return apply(
+            [](const irap::expression& x, const irap::expression& y) { return irap::fmin(x, y); },
+            to_expression(a), to_expression(b)
+        );
+      },
+      py::arg("a"), py::arg("b")
+  );
+  m.def(
+      "fmax",
+      [](py::object a, py::object b) {
+        return apply(
+            [](const irap::expression& x, const irap::expression& y) { return irap::fmax(x, y); },
+            to_expression(a), to_expression(b)
+        );
+      },
+      py::arg("a"), py::arg("b")
+  );
+  m.def(
+      "where",
+      [](py::object condition, py::object if_true, py::object if_false) {
+        return apply(
+            [](const irap::expression& c, const irap::expression& x, const irap::expression& y) {
+              return irap::where(c, x, y);
+            },
+            to_expression(condition), to_expression(if_true), to_bound(if_false)
+        );
+      },
+      py::arg("condition"), py::arg("if_true"), py::arg("if_false") = py::none()
+  );
 }
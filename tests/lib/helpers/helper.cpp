@@ -1,13 +1,23 @@
 #include "helper.h"
 #include <algorithm>
+#include <limits>
 #include <random>
+#include <utility>
 
-std::vector<float> create_random_values(size_t size) {
+std::vector<float> create_random_values(size_t size, unsigned seed) {
   auto values = std::vector<float>(size);
 
-  std::mt19937 g;
+  std::mt19937 g(seed);
   std::uniform_real_distribution<> u;
   std::generate(values.begin(), values.end(), [&]() { return u(g); });
 
   return values;
 }
+
+surfio::irap::irap
+create_random_surface(const surfio::irap::irap_header& header, size_t nan_every, unsigned seed) {
+  auto values = create_random_values(size_t(header.ncol) * size_t(header.nrow), seed);
+  for (size_t i = 0; nan_every && i < values.size(); i += nan_every)
+    values[i] = std::numeric_limits<float>::quiet_NaN();
+  return {.header = header, .values = std::move(values)};
+}
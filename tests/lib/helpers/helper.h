@@ -1,3 +1,12 @@
+#include <irap.h>
+#include <random>
 #include <vector>
 
-std::vector<float> create_random_values(size_t size);
+std::vector<float> create_random_values(size_t size, unsigned seed = std::mt19937::default_seed);
+
+// A surface on the grid of header with random values in [0, 1). If nan_every is not
+// zero, every nan_every-th value, starting with the first, is undefined.
+surfio::irap::irap create_random_surface(
+    const surfio::irap::irap_header& header, size_t nan_every = 0,
+    unsigned seed = std::mt19937::default_seed
+);
@@ -6,6 +6,8 @@
 #include <irap.h>
 #include <irap_export.h>
 #include <irap_import.h>
+#include <span>
+#include <string>
 
 using namespace Catch;
 using namespace surfio;
@@ -26,3 +28,22 @@ SCENARIO("Verify that surfio can read and write irap ascii files", "[test_irap_a
   CHECK_THAT(imported.values, Matchers::Approx(original.values).margin(0.001));
   fs::remove(filename);
 }
+
+SCENARIO(
+    "Verify that surfio can encode irap ascii files block by block", "[test_irap_ascii.cpp]"
+) {
+  fs::path filename("surf_blocks.irap");
+  auto original = create_random_surface(irap::irap_header{.ncol = 301, .nrow = 207}, 97);
+  irap::to_ascii_file(filename, original);
+
+  std::string encoded;
+  irap::read_ascii_file_blocks(
+      filename, 13, [&](const irap::irap_header& h) { irap::encode_header_ascii(h, encoded); },
+      [&](size_t offset, std::span<const float> block) {
+        irap::encode_values_ascii(block, offset, encoded);
+      }
+  );
+
+  CHECK(encoded == irap::to_ascii_string(original));
+  fs::remove(filename);
+}
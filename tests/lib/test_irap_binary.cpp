@@ -6,6 +6,8 @@
 #include <irap.h>
 #include <irap_export.h>
 #include <irap_import.h>
+#include <span>
+#include <string>
 
 using namespace Catch;
 using namespace surfio;
@@ -26,3 +28,23 @@ SCENARIO("Verify that surfio can read and write irap binary files", "[test_irap_
   CHECK_THAT(imported.values, Matchers::Approx(original.values).margin(0.001));
   fs::remove(filename);
 }
+
+SCENARIO(
+    "Verify that surfio can encode irap binary files block by block", "[test_irap_binary.cpp]"
+) {
+  fs::path filename("surf_blocks.irap");
+  auto original = create_random_surface(irap::irap_header{.ncol = 301, .nrow = 207}, 97);
+  irap::to_binary_file(filename, original);
+  const size_t nvalues = original.values.size();
+
+  std::string encoded;
+  irap::read_binary_file_blocks(
+      filename, 13, [&](const irap::irap_header& h) { irap::encode_header_binary(h, encoded); },
+      [&](size_t offset, std::span<const float> block) {
+        irap::encode_values_binary(block, offset, nvalues, encoded);
+      }
+  );
+
+  CHECK(encoded == irap::to_binary_buffer(original));
+  fs::remove(filename);
+}
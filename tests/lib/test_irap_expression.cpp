@@ -0,0 +1,101 @@
+#include "helpers/helper.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+#include <cmath>
+#include <irap.h>
+#include <irap_expression.h>
+#include <limits>
+
+using namespace Catch;
+using namespace surfio;
+
+SCENARIO(
+    "Verify that surfio can evaluate expressions of irap surfaces", "[test_irap_expression.cpp]"
+) {
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  auto header = irap::irap_header{
+      .ncol = 301,
+      .nrow = 207,
+      .xori = 10.,
+      .yori = 20.,
+  };
+  auto top = create_random_surface(header, 11);
+  auto base = create_random_surface(header, 0, 1);
+  const auto& top_values = top.values;
+  const auto& base_values = base.values;
+
+  auto same = [](float x, float y) {
+    return (std::isnan(x) && std::isnan(y)) || std::abs(x - y) <= 1e-6f;
+  };
+
+  THEN("Arithmetic with clipping matches elementwise evaluation") {
+    auto result = (irap::clip(irap::expression(base) - top, 0.25f) * 2.f).evaluate();
+    CHECK(result.header == header);
+    REQUIRE(result.values.size() == top_values.size());
+    for (size_t i = 0; i < top_values.size(); ++i) {
+      auto expected = std::isnan(top_values[i])
+                          ? nan
+                          : std::max(base_values[i] - top_values[i], 0.25f) * 2.f;
+      CHECK(same(result.values[i], expected));
+    }
+  }
+
+  THEN("Comparisons propagate NaN and give 1 or 0") {
+    auto result = (irap::expression(top) < base).evaluate();
+    for (size_t i = 0; i < top_values.size(); ++i) {
+      auto expected = std::isnan(top_values[i]) ? nan : top_values[i] < base_values[i] ? 1.f : 0.f;
+      CHECK(same(result.values[i], expected));
+    }
+  }
+
+  THEN("Masks and NaN-aware minimum combine surfaces") {
+    auto masked = irap::where(irap::expression(base) > 0.5f, top);
+    auto result = irap::fmin(masked, base).evaluate();
+    for (size_t i = 0; i < top_values.size(); ++i) {
+      auto t = base_values[i] > 0.5f ? top_values[i] : nan;
+      auto expected = std::isnan(t) ? base_values[i] : std::min(t, base_values[i]);
+      CHECK(same(result.values[i], expected));
+    }
+  }
+
+  THEN("Shared subexpressions give the same result as repeated ones") {
+    auto thickness = irap::expression(base) - top;
+    auto shared = (thickness * thickness).evaluate();
+    auto repeated = ((irap::expression(base) - top) * (irap::expression(base) - top)).evaluate();
+    CHECK_THAT(shared.values, Matchers::Approx(repeated.values).margin(1e-6));
+    for (size_t i = 0; i < top_values.size(); ++i)
+      CHECK(std::isnan(shared.values[i]) == std::isnan(repeated.values[i]));
+  }
+
+  THEN("Intermediate results that are still needed are not overwritten") {
+    auto a = irap::expression(base);
+    auto b = irap::expression(top);
+    auto result = (((a - b) * (a + b)) - ((a + b) * (a - b))).evaluate();
+    for (size_t i = 0; i < top_values.size(); ++i)
+      CHECK(same(result.values[i], std::isnan(top_values[i]) ? nan : 0.f));
+  }
+
+  THEN("Deep expressions can be evaluated and destroyed") {
+    auto small = irap::irap{
+        .header = irap::irap_header{.ncol = 4, .nrow = 3},
+        .values = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}
+    };
+    auto total = irap::expression(small);
+    for (int i = 0; i < 100000; ++i)
+      total = total + 1.f;
+    auto result = total.evaluate();
+    for (size_t i = 0; i < small.values.size(); ++i)
+      CHECK(result.values[i] == small.values[i] + 100000.f);
+  }
+
+  THEN("Surfaces on different grids can not be combined") {
+    auto shifted = irap::irap{.header = header, .values = base_values};
+    shifted.header.xori += 1.;
+    CHECK_THROWS_AS(irap::expression(top) + shifted, std::domain_error);
+  }
+
+  THEN("Expressions without surfaces can not be evaluated") {
+    CHECK_THROWS_AS((irap::expression(1.f) + 2.f).evaluate(), std::domain_error);
+  }
+}
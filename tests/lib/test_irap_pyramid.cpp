@@ -0,0 +1,99 @@
+#include "helpers/helper.h"
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_all.hpp>
+#include <cmath>
+#include <filesystem>
+#include <irap.h>
+#include <irap_export.h>
+#include <irap_pyramid.h>
+
+using namespace Catch;
+using namespace surfio;
+namespace fs = std::filesystem;
+
+SCENARIO("Verify that surfio can build pyramids of irap surfaces", "[test_irap_pyramid.cpp]") {
+  auto header = irap::irap_header{
+      .ncol = 1003,
+      .nrow = 517,
+      .xori = 10.,
+      .yori = 20.,
+      .xinc = 2.,
+      .yinc = 3.,
+      .rot = 30.,
+  };
+  auto original = create_random_surface(header, 3);
+  const auto& values = original.values;
+  const size_t levels = 9;
+
+  // mean of the defined values in the block of cells that make up one cell on a level
+  auto block_mean = [&](size_t level, size_t col, size_t row) {
+    const size_t factor = size_t{1} << level;
+    double sum = 0.;
+    size_t count = 0;
+    for (auto c = col * factor; c < std::min((col + 1) * factor, size_t(header.ncol)); ++c)
+      for (auto r = row * factor; r < std::min((row + 1) * factor, size_t(header.nrow)); ++r)
+        if (auto v = values[c * header.nrow + r]; !std::isnan(v)) {
+          sum += v;
+          ++count;
+        }
+    return static_cast<float>(sum / count);
+  };
+
+  auto pyramid = irap::make_pyramid(original, levels);
+
+  THEN("Each level has scaled increments and unchanged origin and rotation") {
+    REQUIRE(pyramid.size() == levels);
+    for (size_t l = 1; l <= levels; ++l) {
+      auto& level = pyramid[l - 1];
+      const auto factor = double(size_t{1} << l);
+      CHECK(level.header.ncol == int(std::ceil(header.ncol / factor)));
+      CHECK(level.header.nrow == int(std::ceil(header.nrow / factor)));
+      CHECK(level.header.xinc == header.xinc * factor);
+      CHECK(level.header.yinc == header.yinc * factor);
+      CHECK(level.header.xori == header.xori);
+      CHECK(level.header.yori == header.yori);
+      CHECK(level.header.rot == header.rot);
+      CHECK(level.values.size() == size_t(level.header.ncol * level.header.nrow));
+    }
+  }
+
+  THEN("Each value is the mean of the defined values it covers") {
+    for (size_t l : {1, 4, 9}) {
+      auto& level = pyramid[l - 1];
+      for (size_t col = 0; col < size_t(level.header.ncol); col += 7)
+        for (size_t row = 0; row < size_t(level.header.nrow); row += 5)
+          CHECK_THAT(
+              level.values[col * level.header.nrow + row],
+              Matchers::WithinAbs(block_mean(l, col, row), 1e-5)
+          );
+    }
+  }
+
+  THEN("Building the pyramid while reading a file gives the same result") {
+    fs::path filename("surf.irap");
+    irap::to_binary_file(filename, original);
+    auto from_file = irap::pyramid_from_binary_file(filename, levels);
+    fs::remove(filename);
+
+    REQUIRE(from_file.size() == levels);
+    for (size_t l = 0; l < levels; ++l) {
+      CHECK(from_file[l].header == pyramid[l].header);
+      CHECK_THAT(from_file[l].values, Matchers::Approx(pyramid[l].values).margin(1e-6));
+    }
+  }
+
+  THEN("Building few levels while reading a file gives the same result") {
+    fs::path filename("surf.irap");
+    irap::to_ascii_file(filename, original);
+    auto from_file = irap::pyramid_from_ascii_file(filename, 2, irap::pyramid_reduction::max);
+    auto expected = irap::make_pyramid(original, 2, irap::pyramid_reduction::max);
+    fs::remove(filename);
+
+    REQUIRE(from_file.size() == 2);
+    for (size_t l = 0; l < 2; ++l) {
+      CHECK(from_file[l].header == expected[l].header);
+      CHECK_THAT(from_file[l].values, Matchers::Approx(expected[l].values).margin(1e-4));
+    }
+  }
+}
@@ -0,0 +1,116 @@
+#include "helpers/helper.h"
+#include <catch2/catch_test_macros.hpp>
+#include <irap.h>
+#include <irap_export.h>
+#include <irap_validate.h>
+#include <string>
+
+using namespace surfio;
+
+SCENARIO("Verify that surfio can validate irap files", "[test_irap_validate.cpp]") {
+  auto header = irap::irap_header{
+      .ncol = 301,
+      .nrow = 207,
+  };
+  auto original = create_random_surface(header, 7);
+  const auto& values = original.values;
+  const size_t undef_count = (values.size() + 6) / 7;
+
+  GIVEN("A well-formed binary surface") {
+    auto buffer = irap::to_binary_buffer(original);
+
+    THEN("It is reported as valid") {
+      auto report = irap::validate_binary_buffer(buffer);
+      CHECK(report.valid);
+      CHECK(report.header == header);
+      CHECK(report.value_count == values.size());
+      CHECK(report.undef_count == undef_count);
+    }
+
+    WHEN("It is truncated") {
+      auto report = irap::validate_binary_buffer({buffer.data(), buffer.size() - 10});
+      CHECK_FALSE(report.valid);
+      CHECK(report.value_count < values.size());
+    }
+
+    WHEN("It contains more chunks than declared") {
+      auto size = buffer.size();
+      // a chunk holding one value, with big-endian guards
+      buffer += std::string("\0\0\0\x04\0\0\0\0\0\0\0\x04", 12);
+      auto report = irap::validate_binary_buffer(buffer);
+      CHECK_FALSE(report.valid);
+      CHECK(report.first_bad_offset == size);
+      CHECK(report.value_count == values.size());
+    }
+
+    WHEN("A trailing chunk guard is corrupted") {
+      // header (100 bytes) + 500 chunks of 8 values (40 bytes) + leading guard and 8 values
+      const size_t offset = 100 + 40 * 500 + 36;
+      buffer[offset + 3] = 9;
+      auto report = irap::validate_binary_buffer(buffer);
+      CHECK_FALSE(report.valid);
+      CHECK(report.first_bad_offset == offset);
+      CHECK(report.expected_guard == 32);
+      CHECK(report.actual_guard == 9);
+      // only the values of the chunks before the corrupted one are counted
+      CHECK(report.value_count == 500 * 8);
+      CHECK(report.undef_count == (500 * 8 + 6) / 7);
+    }
+  }
+
+  GIVEN("A surface large enough to be validated in several segments") {
+    auto large = create_random_surface(irap::irap_header{.ncol = 1501, .nrow = 1003}, 7);
+    auto binary = irap::to_binary_buffer(large);
+    auto ascii = irap::to_ascii_string(large);
+
+    THEN("It is reported as valid") {
+      CHECK(irap::validate_binary_buffer(binary).valid);
+      CHECK(irap::validate_ascii_string(ascii).value_count == large.values.size());
+    }
+
+    WHEN("A trailing chunk guard near the end is corrupted") {
+      binary[binary.size() - 1] = 9;
+      auto report = irap::validate_binary_buffer(binary);
+      CHECK_FALSE(report.valid);
+      CHECK(report.first_bad_offset == binary.size() - 4);
+    }
+
+    WHEN("A trailing chunk guard in an early segment is corrupted") {
+      // the values after the corrupted chunk, in later segments, are not counted
+      const size_t chunk = large.values.size() / 8 / 5;
+      const size_t offset = 100 + 40 * chunk + 36;
+      binary[offset + 3] = 9;
+      auto report = irap::validate_binary_buffer(binary);
+      CHECK_FALSE(report.valid);
+      CHECK(report.first_bad_offset == offset);
+      CHECK(report.value_count == chunk * 8);
+      CHECK(report.undef_count == (chunk * 8 + 6) / 7);
+    }
+  }
+
+  GIVEN("A well-formed ascii surface") {
+    auto buffer = irap::to_ascii_string(original);
+
+    THEN("It is reported as valid") {
+      auto report = irap::validate_ascii_string(buffer);
+      CHECK(report.valid);
+      CHECK(report.value_count == values.size());
+      CHECK(report.undef_count == undef_count);
+    }
+
+    WHEN("It contains more values than declared") {
+      auto report = irap::validate_ascii_string(buffer + " 1.0 2.0\n");
+      CHECK_FALSE(report.valid);
+      CHECK(report.first_bad_offset == buffer.size() + 1);
+      CHECK(report.value_count == values.size());
+    }
+
+    WHEN("A value can not be parsed") {
+      auto offset = buffer.find_first_of("0123456789", buffer.size() / 2);
+      buffer[offset] = 'x';
+      auto report = irap::validate_ascii_string(buffer);
+      CHECK_FALSE(report.valid);
+      CHECK(report.first_bad_offset == offset);
+    }
+  }
+}
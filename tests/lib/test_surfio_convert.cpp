@@ -0,0 +1,136 @@
+#include "helpers/helper.h"
+#include <bounded_queue.h>
+#include <catch2/catch_test_macros.hpp>
+#include <convert.h>
+#include <filesystem>
+#include <fstream>
+#include <irap.h>
+#include <irap_export.h>
+#include <irap_import.h>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace surfio;
+namespace fs = std::filesystem;
+
+std::string read_file(const fs::path& file) {
+  std::ifstream in(file, std::ios::binary);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+SCENARIO(
+    "Verify that the bounded queue of surfio-convert can be closed", "[test_surfio_convert.cpp]"
+) {
+  auto queue = cli::bounded_queue<int>(2);
+
+  WHEN("It is closed while holding items") {
+    CHECK(queue.push(1));
+    CHECK(queue.push(2));
+    queue.close();
+
+    THEN("The items are drained before pop reports the end, and push discards items") {
+      CHECK_FALSE(queue.push(3));
+      CHECK(queue.pop() == 1);
+      CHECK(queue.pop() == 2);
+      CHECK_FALSE(queue.pop().has_value());
+    }
+  }
+
+  WHEN("It is closed while a producer waits for room") {
+    CHECK(queue.push(1));
+    CHECK(queue.push(2));
+    std::optional<bool> pushed;
+    {
+      auto producer = std::jthread([&] { pushed = queue.push(3); });
+      queue.close();
+    }
+
+    THEN("The waiting push returns false") { CHECK(pushed == false); }
+  }
+
+  WHEN("Items pass from a producer to a consumer") {
+    std::vector<int> popped;
+    {
+      auto consumer = std::jthread([&] {
+        while (auto item = queue.pop())
+          popped.push_back(*item);
+      });
+      for (int i = 0; i < 1000; ++i)
+        queue.push(i);
+      queue.close();
+    }
+
+    THEN("All of them arrive in order") {
+      REQUIRE(popped.size() == 1000);
+      for (int i = 0; i < 1000; ++i)
+        CHECK(popped[i] == i);
+    }
+  }
+}
+
+SCENARIO("Verify that surfio-convert can convert irap files", "[test_surfio_convert.cpp]") {
+  auto original = create_random_surface(irap::irap_header{.ncol = 301, .nrow = 207}, 97);
+  const fs::path ascii_file("convert_input.irap");
+  const fs::path binary_file("convert_input.gri");
+  const fs::path output("convert_output");
+  irap::to_ascii_file(ascii_file, original);
+  irap::to_binary_file(binary_file, original);
+  auto opts = cli::convert_options{.block_rows = 13, .queue_blocks = 2};
+
+  THEN("The input format is detected") {
+    CHECK(cli::detect_format(ascii_file) == cli::file_format::ascii);
+    CHECK(cli::detect_format(binary_file) == cli::file_format::binary);
+  }
+
+  THEN("Converting ascii to binary gives the same file as importing and exporting") {
+    opts.to = cli::file_format::binary;
+    auto result = cli::convert_file(ascii_file, output, opts);
+    CHECK(result.nvalues == original.values.size());
+    CHECK(read_file(output) == irap::to_binary_buffer(irap::from_ascii_file(ascii_file)));
+  }
+
+  THEN("Converting binary to ascii gives the same file as exporting to ascii") {
+    opts.to = cli::file_format::ascii;
+    cli::convert_file(binary_file, output, opts);
+    CHECK(read_file(output) == read_file(ascii_file));
+  }
+
+  THEN("An output that can not be opened is reported") {
+    CHECK_THROWS_AS(
+        cli::convert_file(ascii_file, fs::path("missing_dir") / "output", opts), std::runtime_error
+    );
+  }
+
+  THEN("A missing input does not remove an existing output") {
+    std::ofstream(output) << "previous";
+    CHECK_THROWS(cli::convert_file("missing.irap", output, opts));
+    CHECK(read_file(output) == "previous");
+  }
+
+#ifdef __linux__
+  THEN("A writer that fails stops the reader and the error is reported") {
+    // writes to /dev/full fail once the stream buffer is flushed, and a device is never
+    // removed as a partial output
+    opts.to = cli::file_format::ascii;
+    CHECK_THROWS_AS(cli::convert_file(binary_file, "/dev/full", opts), std::runtime_error);
+    CHECK(fs::exists("/dev/full"));
+  }
+#endif
+
+  THEN("The partial output of a truncated input is removed") {
+    auto contents = read_file(binary_file);
+    std::ofstream(binary_file, std::ios::binary) << contents.substr(0, contents.size() / 2);
+    CHECK_THROWS(cli::convert_file(binary_file, output, opts));
+    CHECK_FALSE(fs::exists(output));
+  }
+
+  fs::remove(ascii_file);
+  fs::remove(binary_file);
+  fs::remove(output);
+}
@@ -0,0 +1,45 @@
+import numpy as np
+import pytest
+import surfio
+
+
+def random_surface(
+    seed=0,
+    ncol=41,
+    nrow=29,
+    nan_fraction=0.1,
+    mean=2000.0,
+    xori=10.0,
+    yori=20.0,
+    xinc=2.0,
+    yinc=3.0,
+    rot=30.0,
+    xrot=0.0,
+    yrot=0.0,
+):
+    """A surface with normally distributed float32 values, of which about
+    nan_fraction are undefined"""
+    rng = np.random.default_rng(seed)
+    values = rng.normal(mean, 50, size=(ncol, nrow)).astype(np.float32)
+    values[rng.random((ncol, nrow)) < nan_fraction] = np.nan
+    return surfio.IrapSurface(
+        surfio.IrapHeader(
+            ncol=ncol,
+            nrow=nrow,
+            xori=xori,
+            yori=yori,
+            xinc=xinc,
+            yinc=yinc,
+            xmax=xori + (ncol - 1) * xinc,
+            ymax=yori + (nrow - 1) * yinc,
+            rot=rot,
+            xrot=xrot,
+            yrot=yrot,
+        ),
+        values=values,
+    )
+
+
+@pytest.fixture
+def make_surface():
+    return random_surface
@@ -0,0 +1,178 @@
+import subprocess
+import sys
+import sysconfig
+import threading
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+import pytest
+import surfio
+
+NUM_THREADS = 8
+NUM_ITERATIONS = 20
+
+
+def run_concurrently(func, num_threads=NUM_THREADS):
+    """Call func(thread_index) from num_threads threads that start at the same time"""
+    barrier = threading.Barrier(num_threads)
+
+    def wrapper(index):
+        barrier.wait()
+        return func(index)
+
+    with ThreadPoolExecutor(max_workers=num_threads) as executor:
+        return list(executor.map(wrapper, range(num_threads)))
+
+
+def assert_surfaces_equal(surface, other):
+    assert surface.header == other.header
+    assert np.allclose(surface.values, other.values, equal_nan=True, atol=1e-3)
+
+
+@pytest.mark.skipif(
+    not sysconfig.get_config_var("Py_GIL_DISABLED"),
+    reason="only relevant for free-threaded python",
+)
+def test_importing_surfio_does_not_enable_the_gil():
+    # in a new interpreter, as other modules imported by the tests can enable it
+    subprocess.run(
+        [
+            sys.executable,
+            "-c",
+            "import surfio, sys; assert not sys._is_gil_enabled()",
+        ],
+        check=True,
+    )
+
+
+def test_concurrent_imports_of_the_same_binary_file(tmp_path, make_surface):
+    surface = make_surface(ncol=101, nrow=67)
+    surface.to_binary_file(str(tmp_path / "test.irap"))
+
+    def work(_):
+        return [
+            surfio.IrapSurface.from_binary_file(str(tmp_path / "test.irap"))
+            for _ in range(NUM_ITERATIONS)
+        ]
+
+    for imported in run_concurrently(work):
+        for srf in imported:
+            assert_surfaces_equal(srf, surface)
+
+
+def test_concurrent_imports_of_the_same_ascii_buffer(make_surface):
+    surface = make_surface(ncol=101, nrow=67)
+    buffer = surface.to_ascii_string()
+
+    def work(_):
+        return [
+            surfio.IrapSurface.from_ascii_string(buffer) for _ in range(NUM_ITERATIONS)
+        ]
+
+    for imported in run_concurrently(work):
+        for srf in imported:
+            assert_surfaces_equal(srf, surface)
+
+
+def test_concurrent_exports_of_the_same_surface(make_surface):
+    surface = make_surface(ncol=101, nrow=67)
+    expected_ascii = surface.to_ascii_string()
+    expected_binary = surface.to_binary_buffer()
+
+    def work(_):
+        return [
+            (surface.to_ascii_string(), surface.to_binary_buffer())
+            for _ in range(NUM_ITERATIONS)
+        ]
+
+    for exported in run_concurrently(work):
+        for ascii_string, binary_buffer in exported:
+            assert ascii_string == expected_ascii
+            assert binary_buffer == expected_binary
+
+
+def test_concurrent_round_trips_of_different_surfaces(tmp_path, make_surface):
+    surfaces = [
+        make_surface(seed=seed, ncol=101, nrow=67) for seed in range(NUM_THREADS)
+    ]
+
+    def work(index):
+        binary_path = str(tmp_path / f"{index}.irap")
+        ascii_path = str(tmp_path / f"{index}.txt")
+        results = []
+        for _ in range(NUM_ITERATIONS // 4):
+            surfaces[index].to_binary_file(binary_path)
+            surfaces[index].to_ascii_file(ascii_path)
+            results.append(surfio.IrapSurface.from_binary_file(binary_path))
+            results.append(surfio.IrapSurface.from_ascii_file(ascii_path))
+            results.append(
+                surfio.IrapSurface.from_binary_buffer(
+                    surfaces[index].to_binary_buffer()
+                )
+            )
+        return results
+
+    for index, results in enumerate(run_concurrently(work)):
+        for srf in results:
+            assert_surfaces_equal(srf, surfaces[index])
+
+
+def test_concurrent_validation_and_pyramids_of_the_same_surface(make_surface):
+    surface = make_surface(ncol=500, nrow=300)
+    buffer = surface.to_binary_buffer()
+    expected = surface.make_pyramid(3)
+
+    def work(_):
+        results = []
+        for _ in range(NUM_ITERATIONS // 4):
+            report = surfio.validate_binary_buffer(buffer)
+            results.append((report, surface.make_pyramid(3)))
+        return results
+
+    for results in run_concurrently(work):
+        for report, pyramid in results:
+            assert report.valid
+            for level, expected_level in zip(pyramid, expected, strict=True):
+                assert_surfaces_equal(level, expected_level)
+
+
+def test_values_can_be_assigned_while_other_threads_use_the_surface(make_surface):
+    candidates = [
+        make_surface(seed=seed, ncol=101, nrow=67).values for seed in range(4)
+    ]
+    surface = make_surface(seed=0, ncol=101, nrow=67)
+    expected_buffers = {
+        surfio.IrapSurface(surface.header, values).to_binary_buffer()
+        for values in candidates
+    }
+
+    def work(index):
+        if index == 0:
+            for _ in range(NUM_ITERATIONS * 20):
+                for values in candidates:
+                    # a new array, so the previous one is freed when it is replaced
+                    surface.values = values.copy()
+            return []
+        results = []
+        for _ in range(NUM_ITERATIONS):
+            results.append(surface.to_binary_buffer())
+            results.append((surface + 1.0).evaluate().values)
+        return results
+
+    for results in run_concurrently(work):
+        for buffer, values in zip(results[::2], results[1::2], strict=True):
+            assert buffer in expected_buffers
+            assert any(
+                np.array_equal(values, candidate + 1.0, equal_nan=True)
+                for candidate in candidates
+            )
+
+
+def test_concurrent_failing_imports():
+    def work(_):
+        for _ in range(NUM_ITERATIONS):
+            with pytest.raises(ValueError, match="Failed to read irap headers"):
+                surfio.IrapSurface.from_ascii_string("-996 1")
+        return True
+
+    assert all(run_concurrently(work))
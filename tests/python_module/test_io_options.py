@@ -0,0 +1,133 @@
+import numpy as np
+import pytest
+import surfio
+
+BACKENDS = [
+    surfio.IoBackend.automatic,
+    surfio.IoBackend.mmap,
+    surfio.IoBackend.pread,
+    surfio.IoBackend.direct,
+]
+
+
+@pytest.fixture
+def surface(make_surface):
+    return make_surface(seed=1, ncol=37, nrow=23)
+
+
+@pytest.fixture(params=["ascii", "binary"])
+def file_format(request):
+    return request.param
+
+
+def write_surface(surface, path, file_format):
+    if file_format == "ascii":
+        surface.to_ascii_file(path)
+    else:
+        surface.to_binary_file(path)
+
+
+def read_surface(path, file_format, **kwargs):
+    if file_format == "ascii":
+        return surfio.IrapSurface.from_ascii_file(path, **kwargs)
+    return surfio.IrapSurface.from_binary_file(path, **kwargs)
+
+
+def validate_file(path, file_format, **kwargs):
+    if file_format == "ascii":
+        return surfio.validate_ascii_file(path, **kwargs)
+    return surfio.validate_binary_file(path, **kwargs)
+
+
+def pyramid_from_file(path, file_format, levels, **kwargs):
+    if file_format == "ascii":
+        return surfio.IrapSurface.pyramid_from_ascii_file(path, levels, **kwargs)
+    return surfio.IrapSurface.pyramid_from_binary_file(path, levels, **kwargs)
+
+
+def test_io_options_defaults():
+    options = surfio.IoOptions()
+    assert options.backend == surfio.IoBackend.automatic
+    assert not options.populate
+    assert not options.huge_pages
+
+
+@pytest.mark.parametrize("backend", BACKENDS)
+@pytest.mark.parametrize("populate", [False, True])
+def test_all_backends_read_the_same_surface(
+    tmp_path, surface, file_format, backend, populate
+):
+    path = tmp_path / "test.irap"
+    write_surface(surface, path, file_format)
+    options = surfio.IoOptions(backend=backend, populate=populate, huge_pages=populate)
+
+    result = read_surface(path, file_format, io_options=options)
+
+    assert result.header == surface.header
+    assert np.allclose(result.values, surface.values, equal_nan=True, atol=1e-3)
+
+
+def test_direct_backend_reads_files_that_end_within_a_block(tmp_path, make_surface):
+    # direct reads are done in blocks of 4096 bytes, and the last read is short
+    surface = make_surface(seed=1, ncol=101, nrow=67)
+    path = tmp_path / "test.irap"
+    surface.to_binary_file(path)
+    assert path.stat().st_size > 4096
+    assert path.stat().st_size % 4096 != 0
+
+    result = surfio.IrapSurface.from_binary_file(
+        path, io_options=surfio.IoOptions(backend=surfio.IoBackend.direct)
+    )
+
+    assert result.header == surface.header
+    np.testing.assert_array_equal(result.values, surface.values)
+
+
+@pytest.mark.parametrize("backend", BACKENDS)
+def test_all_backends_validate_and_build_pyramids(
+    tmp_path, surface, file_format, backend
+):
+    path = tmp_path / "test.irap"
+    write_surface(surface, path, file_format)
+    options = surfio.IoOptions(backend=backend)
+
+    assert validate_file(path, file_format, io_options=options)
+    pyramid = pyramid_from_file(path, file_format, 2, io_options=options)
+    assert [level.values.shape for level in pyramid] == [(19, 12), (10, 6)]
+
+
+@pytest.mark.parametrize("backend", ["mmap", "pread", "direct"])
+def test_backend_can_be_chosen_by_environment_variable(
+    monkeypatch, tmp_path, surface, file_format, backend
+):
+    monkeypatch.setenv("SURFIO_IO_BACKEND", backend)
+    path = tmp_path / "test.irap"
+    write_surface(surface, path, file_format)
+
+    result = read_surface(path, file_format)
+
+    assert result.header == surface.header
+
+
+def test_unknown_backend_in_environment_variable_errors(
+    monkeypatch, tmp_path, surface, file_format
+):
+    monkeypatch.setenv("SURFIO_IO_BACKEND", "carrier-pigeon")
+    path = tmp_path / "test.irap"
+    write_surface(surface, path, file_format)
+
+    with pytest.raises(ValueError, match="Unknown SURFIO_IO_BACKEND"):
+        read_surface(path, file_format)
+    # an explicitly chosen backend ignores the environment variable
+    result = read_surface(
+        path, file_format, io_options=surfio.IoOptions(backend=surfio.IoBackend.pread)
+    )
+    assert result.header == surface.header
+
+
+@pytest.mark.parametrize("backend", [surfio.IoBackend.pread, surfio.IoBackend.direct])
+def test_reading_missing_file_with_read_backends_errors(tmp_path, backend):
+    with pytest.raises(RuntimeError, match="failed to read file"):
+        surfio.IrapSurface.from_binary_file(
+            tmp_path / "missing.irap", io_options=surfio.IoOptions(backend=backend)
+        )
@@ -134,6 +134,69 @@ def test_reading_two_by_three_results_in_f_order_values():
     assert surface.values.tolist() == [[1.0, 4.0], [2.0, 5.0], [3.0, 6.0]]
 
 
+@pytest.mark.parametrize("to_buffer", [bytes, bytearray, memoryview])
+def test_reading_from_buffer_protocol_objects(to_buffer):
+    surface = surfio.IrapSurface.from_ascii_string(
+        to_buffer(
+            b"""\
+            -996 2 2.0 2.0
+            0.0 2.0 0.0 2.0
+            3 0.0 0.0 0.0
+            0  0  0  0  0  0  0
+            1.000000 2.000000 3.000000
+            4.000000 5.000000 6.000000
+            """
+        )
+    )
+    assert surface.values.tolist() == [[1.0, 4.0], [2.0, 5.0], [3.0, 6.0]]
+
+
+def test_validating_ascii_string():
+    report = surfio.validate_ascii_string(
+        """\
+        -996 2 2.0 2.0
+        0.0 2.0 0.0 2.0
+        3 0.0 0.0 0.0
+        0  0  0  0  0  0  0
+        1.000000 2.000000 9999900.000000
+        4.000000 5.000000 6.000000
+        """
+    )
+    assert report
+    assert report.value_count == 6
+    assert report.undef_count == 1
+
+
+def test_validating_ascii_string_with_too_few_values():
+    report = surfio.validate_ascii_string(
+        """\
+        -996 2 2.0 2.0
+        0.0 2.0 0.0 2.0
+        3 0.0 0.0 0.0
+        0  0  0  0  0  0  0
+        1.000000 2.000000 3.000000
+        """
+    )
+    assert not report.valid
+    assert report.value_count == 3
+    assert report.expected_values == 6
+    assert "End of file reached" in report.error
+
+
+def test_validating_ascii_string_with_bad_value():
+    buffer = """\
+        -996 2 2.0 2.0
+        0.0 2.0 0.0 2.0
+        3 0.0 0.0 0.0
+        0  0  0  0  0  0  0
+        1.000000 2.000000 not_a_number
+        4.000000 5.000000 6.000000
+        """
+    report = surfio.validate_ascii_string(buffer)
+    assert not report.valid
+    assert report.first_bad_offset == buffer.index("not_a_number")
+
+
 def test_reading_two_by_three_results_in_f_order_values_from_file(tmp_path):
     irap_path = tmp_path / "test.irap"
     irap_path.write_text(
@@ -1,3 +1,4 @@
+import mmap
 import struct
 from io import BytesIO
 import sys
@@ -5,11 +6,17 @@ import sys
 import numpy as np
 import pytest
 import surfio
-import xtgeo
+
+try:
+    import xtgeo
+except ImportError:  # xtgeo is not installed on free-threaded python
+    xtgeo = None
+
+requires_xtgeo = pytest.mark.skipif(xtgeo is None, reason="xtgeo is not installed")
 
 
 def compare_xtgeo_surface_with_surfio_header(
-    xtgeo_surface: xtgeo.RegularSurface, surfio_header: surfio.IrapHeader
+    xtgeo_surface: "xtgeo.RegularSurface", surfio_header: surfio.IrapHeader
 ):
     assert xtgeo_surface.ncol == surfio_header.ncol
     assert xtgeo_surface.nrow == surfio_header.nrow
@@ -34,6 +41,7 @@ def test_reading_short_header_results_in_value_error():
         _ = surfio.IrapSurface.from_ascii_string("-996 1")
 
 
+@requires_xtgeo
 def test_short_files_result_in_value_error():
     values = np.random.normal(2000, 50, size=12)
     srf = xtgeo.RegularSurface(ncol=3, nrow=4, xinc=1, yinc=1, values=values)
@@ -44,6 +52,7 @@ def test_short_files_result_in_value_error():
         _ = surfio.IrapSurface.from_binary_buffer(file_buffer.getvalue())
 
 
+@requires_xtgeo
 def test_binary_xtgeo_is_imported_correctly_in_surfio():
     values = np.random.normal(2000, 50, size=12)
     srf = xtgeo.RegularSurface(ncol=3, nrow=4, xinc=1, yinc=1, values=values)
@@ -78,6 +87,117 @@ def test_surfio_can_export_values_in_fortran_order():
     assert srf.header == srf_imported.header
 
 
+@pytest.mark.parametrize(
+    "layout",
+    [np.asfortranarray, lambda v: v[::-1, ::-1], lambda v: v.astype(np.float64)],
+)
+def test_surfio_can_export_values_assigned_in_any_layout(layout):
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=3, nrow=2, xinc=1.0, yinc=1.0, xmax=2.0, ymax=1.0),
+        values=np.zeros((3, 2), dtype=np.float32),
+    )
+    srf.values = layout(np.arange(6, dtype=np.float32).reshape((3, 2)))
+    srf_imported = surfio.IrapSurface.from_binary_buffer(srf.to_binary_buffer())
+
+    assert np.array_equal(srf.values, srf_imported.values)
+    assert np.array_equal(
+        srf.values, surfio.IrapSurface.from_ascii_string(srf.to_ascii_string()).values
+    )
+
+
+@pytest.mark.parametrize(
+    "to_buffer",
+    [
+        bytes,
+        bytearray,
+        memoryview,
+        lambda b: np.frombuffer(b, dtype=np.uint8),
+    ],
+)
+def test_binary_buffer_can_be_any_buffer_protocol_object(to_buffer):
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=3, nrow=2, xinc=1.0, yinc=1.0, xmax=2.0, ymax=1.0),
+        values=np.arange(6, dtype=np.float32).reshape((3, 2)),
+    )
+    srf_imported = surfio.IrapSurface.from_binary_buffer(
+        to_buffer(srf.to_binary_buffer())
+    )
+
+    assert np.allclose(srf.values, srf_imported.values)
+    assert srf.header == srf_imported.header
+
+
+def test_binary_buffer_can_be_a_memory_map(tmp_path):
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=3, nrow=2, xinc=1.0, yinc=1.0, xmax=2.0, ymax=1.0),
+        values=np.arange(6, dtype=np.float32).reshape((3, 2)),
+    )
+    srf.to_binary_file(str(tmp_path / "test.irap"))
+    with (
+        open(tmp_path / "test.irap", "rb") as f,
+        mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mm,
+    ):
+        srf_imported = surfio.IrapSurface.from_binary_buffer(mm)
+
+    assert np.allclose(srf.values, srf_imported.values)
+
+
+def test_non_contiguous_binary_buffer_results_in_buffer_error():
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=3, nrow=2, xinc=1.0, yinc=1.0, xmax=2.0, ymax=1.0),
+        values=np.arange(6, dtype=np.float32).reshape((3, 2)),
+    )
+    buffer = np.frombuffer(srf.to_binary_buffer() * 2, dtype=np.uint8)[::2]
+    with pytest.raises(BufferError, match="C-contiguous"):
+        surfio.IrapSurface.from_binary_buffer(buffer)
+
+
+def test_validating_binary_file(tmp_path):
+    values = np.arange(30, dtype=np.float32).reshape((5, 6))
+    values[1, 2] = np.nan
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=5, nrow=6, xinc=1.0, yinc=1.0, xmax=4.0, ymax=5.0),
+        values=values,
+    )
+    srf.to_binary_file(str(tmp_path / "test.irap"))
+    report = surfio.validate_binary_file(str(tmp_path / "test.irap"))
+
+    assert report
+    assert report.first_bad_offset is None
+    assert report.header == srf.header
+    assert report.expected_values == report.value_count == 30
+    assert report.undef_count == 1
+
+
+def test_validating_binary_buffer_with_mismatching_chunk_guard():
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=3, nrow=4, xinc=1.0, yinc=1.0, xmax=2.0, ymax=3.0),
+        values=np.zeros((3, 4), dtype=np.float32),
+    )
+    buffer = bytearray(srf.to_binary_buffer())
+    # header is 100 bytes, followed by a chunk of 8 values with 4 byte guards
+    buffer[100 + 4 + 32 : 100 + 4 + 32 + 4] = struct.pack(">i", 28)
+    report = surfio.validate_binary_buffer(buffer)
+
+    assert not report.valid
+    assert report.first_bad_offset == 136
+    assert report.expected_guard == 32
+    assert report.actual_guard == 28
+
+
+def test_validating_truncated_binary_buffer():
+    srf = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=3, nrow=4, xinc=1.0, yinc=1.0, xmax=2.0, ymax=3.0),
+        values=np.zeros((3, 4), dtype=np.float32),
+    )
+    report = surfio.validate_binary_buffer(srf.to_binary_buffer()[:-4])
+
+    assert not report.valid
+    assert report.value_count == 8
+    assert report.expected_values == 12
+
+
+@requires_xtgeo
 def test_xtgeo_can_import_data_exported_from_surfio(tmp_path):
     srf = surfio.IrapSurface(
         surfio.IrapHeader(ncol=3, nrow=2, xinc=1.0, yinc=1.0, xmax=2.0, ymax=1.0),
@@ -0,0 +1,118 @@
+import numpy as np
+import pytest
+import surfio
+
+
+@pytest.fixture
+def top(make_surface):
+    return make_surface(seed=3, mean=1000.0)
+
+
+@pytest.fixture
+def base(make_surface):
+    return make_surface(seed=4, mean=1010.0, nan_fraction=0.0)
+
+
+def test_operators_build_lazy_expressions(top, base):
+    expression = base - top
+    assert isinstance(expression, surfio.SurfaceExpression)
+    assert expression.header == top.header
+
+
+def test_isochore_matches_numpy(top, base):
+    result = ((base - top).clip(0) * 0.5).evaluate()
+
+    assert isinstance(result, surfio.IrapSurface)
+    assert result.header == top.header
+    np.testing.assert_allclose(
+        result.values, np.clip(base.values - top.values, 0, None) * 0.5, rtol=1e-6
+    )
+
+
+def test_expressions_read_values_when_evaluated(top, base):
+    expression = base - top
+    base.values[0, 0] = top.values[0, 0] = 1.0
+    assert expression.evaluate().values[0, 0] == 0.0
+
+
+@pytest.mark.parametrize(
+    "operation, expected",
+    [
+        (lambda a, b: a + b, np.add),
+        (lambda a, b: a - b, np.subtract),
+        (lambda a, b: a * b, np.multiply),
+        (lambda a, b: a / b, np.divide),
+        (lambda a, b: 2 - a, lambda a, b: 2 - a),
+        (lambda a, b: 1 / a, lambda a, b: 1 / a),
+        (lambda a, b: -a, lambda a, b: -a),
+        (lambda a, b: abs(a - b), lambda a, b: np.abs(a - b)),
+        (surfio.fmin, np.fmin),
+        (surfio.fmax, np.fmax),
+    ],
+)
+def test_arithmetic_matches_numpy(top, base, operation, expected):
+    result = operation(top, base).evaluate()
+    np.testing.assert_allclose(
+        result.values, expected(top.values, base.values), rtol=1e-6
+    )
+
+
+def test_deep_expressions_can_be_evaluated_and_deleted(top):
+    total = top
+    for _ in range(100_000):
+        total = total + 1.0
+    np.testing.assert_allclose(total.evaluate().values, top.values + 100_000, rtol=1e-6)
+    del total
+
+
+def test_comparisons_give_one_zero_or_nan(top, base):
+    result = (top < base).evaluate().values
+    expected = np.where(
+        np.isnan(top.values), np.nan, (top.values < base.values).astype(np.float32)
+    )
+    np.testing.assert_array_equal(result, expected)
+
+
+def test_logical_operators_combine_masks(top, base):
+    result = ((top > 990) & ~(base > 1020) | (base < 980)).evaluate().values
+    expected = np.where(
+        np.isnan(top.values),
+        np.nan,
+        ((top.values > 990) & ~(base.values > 1020) | (base.values < 980)),
+    )
+    np.testing.assert_array_equal(result, expected)
+
+
+def test_where_masks_values(top, base):
+    masked = surfio.where(base > 1010, top).evaluate().values
+    chosen = surfio.where(base > 1010, top, base).evaluate().values
+
+    np.testing.assert_array_equal(
+        masked, np.where(base.values > 1010, top.values, np.nan)
+    )
+    np.testing.assert_array_equal(
+        chosen, np.where(base.values > 1010, top.values, base.values)
+    )
+
+
+def test_clip_ignores_missing_bounds(top):
+    result = top.clip(upper=1000).evaluate().values
+    np.testing.assert_array_equal(result, np.minimum(top.values, np.float32(1000)))
+
+
+def test_surfaces_on_different_grids_can_not_be_combined(top, make_surface):
+    shifted = make_surface(xori=11.0)
+    with pytest.raises(ValueError, match="different grids, xori"):
+        top + shifted
+
+
+def test_unsupported_operands_raise_type_error(top):
+    with pytest.raises(TypeError):
+        top + "a"
+    with pytest.raises(TypeError):
+        top + np.zeros((41, 29))
+
+
+def test_expression_truth_value_is_ambiguous(top):
+    with pytest.raises(TypeError, match="ambiguous"):
+        bool(top > 0)
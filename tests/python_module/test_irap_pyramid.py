@@ -0,0 +1,85 @@
+import numpy as np
+import pytest
+import surfio
+
+
+@pytest.fixture
+def surface(make_surface):
+    surface = make_surface(ncol=5, nrow=6, nan_fraction=0.0)
+    surface.values[0, 0] = np.nan
+    return surface
+
+
+def test_pyramid_levels_have_scaled_increments(surface):
+    pyramid = surface.make_pyramid(2)
+
+    assert [level.values.shape for level in pyramid] == [(3, 3), (2, 2)]
+    for factor, level in zip([2, 4], pyramid, strict=True):
+        assert level.header.xinc == surface.header.xinc * factor
+        assert level.header.yinc == surface.header.yinc * factor
+        assert level.header.xori == surface.header.xori
+        assert level.header.yori == surface.header.yori
+        assert level.header.rot == surface.header.rot
+        assert level.header.xmax == (
+            level.header.xori + (level.header.ncol - 1) * level.header.xinc
+        )
+
+
+@pytest.mark.parametrize(
+    "reduction, func",
+    [
+        (surfio.PyramidReduction.mean, np.nanmean),
+        (surfio.PyramidReduction.min, np.nanmin),
+        (surfio.PyramidReduction.max, np.nanmax),
+    ],
+)
+def test_pyramid_reduction_ignores_nan(surface, reduction, func):
+    level = surface.make_pyramid(1, reduction)[0]
+
+    for col in range(3):
+        for row in range(3):
+            block = surface.values[2 * col : 2 * col + 2, 2 * row : 2 * row + 2]
+            assert level.values[col, row] == pytest.approx(func(block))
+
+
+@pytest.mark.parametrize(
+    "layout",
+    [np.asfortranarray, lambda v: v[:, ::-1], lambda v: v.astype(np.float64)],
+)
+def test_pyramid_of_non_contiguous_values(surface, layout):
+    surface.values = layout(surface.values)
+    contiguous = surfio.IrapSurface(
+        surface.header, np.ascontiguousarray(surface.values, dtype=np.float32)
+    )
+
+    for level, expected in zip(
+        surface.make_pyramid(2), contiguous.make_pyramid(2), strict=True
+    ):
+        np.testing.assert_array_equal(level.values, expected.values)
+
+
+def test_pyramid_of_undefined_block_is_undefined():
+    surface = surfio.IrapSurface(
+        surfio.IrapHeader(ncol=2, nrow=2),
+        values=np.full((2, 2), np.nan, dtype=np.float32),
+    )
+    assert np.isnan(surface.make_pyramid(1)[0].values).all()
+
+
+def test_pyramid_from_file_equals_pyramid_of_imported_surface(surface, tmp_path):
+    surface.to_binary_file(str(tmp_path / "test.irap"))
+    surface.to_ascii_file(str(tmp_path / "test.txt"))
+    expected = surface.make_pyramid(3)
+
+    for pyramid in [
+        surfio.IrapSurface.pyramid_from_binary_file(str(tmp_path / "test.irap"), 3),
+        surfio.IrapSurface.pyramid_from_ascii_file(str(tmp_path / "test.txt"), 3),
+    ]:
+        for level, expected_level in zip(pyramid, expected, strict=True):
+            assert level.header == expected_level.header
+            assert np.allclose(level.values, expected_level.values, equal_nan=True)
+
+
+def test_pyramid_with_no_levels_results_in_value_error(surface):
+    with pytest.raises(ValueError, match="Number of pyramid levels"):
+        surface.make_pyramid(0)
@@ -0,0 +1,127 @@
+import pickle
+from concurrent.futures import ProcessPoolExecutor
+from multiprocessing import shared_memory
+
+import numpy as np
+import pytest
+import surfio
+
+
+@pytest.fixture
+def surface(make_surface):
+    return make_surface(seed=2, ncol=31, nrow=17, xrot=1.0, yrot=2.0)
+
+
+@pytest.fixture
+def shm(surface):
+    segment = surface.to_shared_memory()
+    yield segment
+    segment.close()
+    segment.unlink()
+
+
+def assert_surfaces_equal(surface, other):
+    assert surface.header == other.header
+    np.testing.assert_array_equal(surface.values, other.values)
+
+
+def sum_of_shared_surface(name):
+    surface = surfio.IrapSurface.from_shared_memory(name)
+    return float(np.nansum(surface.values))
+
+
+def mean_of_surface(surface):
+    return float(np.nanmean(surface.values))
+
+
+def test_header_can_be_pickled(surface):
+    assert pickle.loads(pickle.dumps(surface.header)) == surface.header
+
+
+@pytest.mark.parametrize("protocol", range(2, pickle.HIGHEST_PROTOCOL + 1))
+def test_surface_can_be_pickled(surface, protocol):
+    assert_surfaces_equal(
+        pickle.loads(pickle.dumps(surface, protocol=protocol)), surface
+    )
+
+
+def test_pickle_protocol_5_passes_values_out_of_band(surface):
+    buffers = []
+    data = pickle.dumps(surface, protocol=5, buffer_callback=buffers.append)
+
+    assert len(buffers) == 1
+    assert len(data) < surface.values.nbytes
+    result = pickle.loads(data, buffers=buffers)
+    assert_surfaces_equal(result, surface)
+    assert np.shares_memory(result.values, surface.values)
+
+
+def test_non_contiguous_values_can_be_pickled(surface):
+    surface.values = np.asfortranarray(surface.values)
+    result = pickle.loads(pickle.dumps(surface, protocol=5))
+    assert_surfaces_equal(result, surface)
+    assert result.values.flags.c_contiguous
+
+
+def test_surface_can_be_sent_to_another_process(surface):
+    with ProcessPoolExecutor(max_workers=1) as executor:
+        mean = executor.submit(mean_of_surface, surface).result()
+    assert mean == pytest.approx(float(np.nanmean(surface.values)))
+
+
+def test_surface_can_be_attached_from_shared_memory(surface, shm):
+    result = surfio.IrapSurface.from_shared_memory(shm)
+    assert_surfaces_equal(result, surface)
+    del result
+
+
+def test_shared_memory_surfaces_share_values(shm):
+    first = surfio.IrapSurface.from_shared_memory(shm)
+    second = surfio.IrapSurface.from_shared_memory(shm.name)
+    first.values[0, 0] = 42.0
+    assert second.values[0, 0] == 42.0
+    del first, second
+
+
+def test_shared_memory_surface_can_be_attached_in_another_process(surface, shm):
+    with ProcessPoolExecutor(max_workers=1) as executor:
+        total = executor.submit(sum_of_shared_surface, shm.name).result()
+    assert total == pytest.approx(float(np.nansum(surface.values)))
+
+
+def test_shared_memory_surface_outlives_the_attaching_object(surface, shm):
+    result = surfio.IrapSurface.from_shared_memory(shm.name)
+    # the segment stays mapped while the values exist
+    values = result.values
+    del result
+    np.testing.assert_array_equal(values, surface.values)
+    del values
+
+
+def test_shared_memory_can_be_given_a_name(surface):
+    name = f"surfio_test_{id(surface)}"
+    segment = surface.to_shared_memory(name)
+    try:
+        assert segment.name.lstrip("/") == name
+        result = surfio.IrapSurface.from_shared_memory(name)
+        assert_surfaces_equal(result, surface)
+        del result
+    finally:
+        segment.close()
+        segment.unlink()
+
+
+def test_shared_memory_without_surface_errors():
+    segment = shared_memory.SharedMemory(create=True, size=256)
+    try:
+        with pytest.raises(ValueError, match="does not hold an IrapSurface"):
+            surfio.IrapSurface.from_shared_memory(segment)
+    finally:
+        segment.close()
+        segment.unlink()
+
+
+def test_mismatching_values_cannot_be_shared(surface):
+    surface.values = np.zeros((3, 3), dtype=np.float32)
+    with pytest.raises(ValueError, match="Dimensions of values do not match"):
+        surface.to_shared_memory()